@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+    Allocation hooks behind Benchmarks::ScopedAllocationCounter.
+
+    Only the benchmark console project compiles this file, so the plugin
+    never carries a replaced allocator.
+
+    Linux: the project links with --wrap for malloc, calloc, realloc,
+    aligned_alloc and posix_memalign, so those calls from our code and from
+    JUCE's (HeapBlock included) land in the __wrap_ functions below.
+    libstdc++'s operator new calls malloc from inside the shared library,
+    out of reach of --wrap, so every operator new is replaced here to go
+    through the wrapped functions too.
+
+    Windows: the debug CRT's allocation hook already sees malloc, realloc
+    and operator new alike, but only in the Debug configuration.
+
+  ==============================================================================
+*/
+
+#include "../Source/Benchmarks.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_WINDOWS && defined (_DEBUG)
+ #include <crtdbg.h>
+#endif
+
+namespace
+{
+    //only the measuring thread is counted, and only while a counter is in scope
+    thread_local bool countThisThread = false;
+    std::atomic<juce::int64> allocationCount{ 0 };
+
+    inline void countAllocation() noexcept
+    {
+        if (countThisThread)
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+namespace Benchmarks
+{
+    ScopedAllocationCounter::ScopedAllocationCounter()
+    {
+        allocationCount.store(0);
+        countThisThread = true;
+    }
+
+    ScopedAllocationCounter::~ScopedAllocationCounter()
+    {
+        countThisThread = false;
+    }
+
+    juce::int64 ScopedAllocationCounter::getCount() const
+    {
+        return allocationCount.load();
+    }
+}
+
+#if JUCE_LINUX
+
+extern "C"
+{
+    void* __real_malloc(size_t size);
+    void* __real_calloc(size_t count, size_t size);
+    void* __real_realloc(void* ptr, size_t size);
+    void* __real_aligned_alloc(size_t alignment, size_t size);
+    int __real_posix_memalign(void** ptr, size_t alignment, size_t size);
+
+    void* __wrap_malloc(size_t size)
+    {
+        countAllocation();
+        return __real_malloc(size);
+    }
+
+    void* __wrap_calloc(size_t count, size_t size)
+    {
+        countAllocation();
+        return __real_calloc(count, size);
+    }
+
+    void* __wrap_realloc(void* ptr, size_t size)
+    {
+        countAllocation();
+        return __real_realloc(ptr, size);
+    }
+
+    void* __wrap_aligned_alloc(size_t alignment, size_t size)
+    {
+        countAllocation();
+        return __real_aligned_alloc(alignment, size);
+    }
+
+    int __wrap_posix_memalign(void** ptr, size_t alignment, size_t size)
+    {
+        countAllocation();
+        return __real_posix_memalign(ptr, alignment, size);
+    }
+}
+
+bool Benchmarks::ScopedAllocationCounter::isAvailable() { return true; }
+
+namespace
+{
+    void* allocate(std::size_t size) noexcept
+    {
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+    {
+        //aligned_alloc wants the size to be a multiple of the alignment
+        auto align = juce::jmax((std::size_t)alignment, sizeof(void*));
+        auto rounded = (juce::jmax(size, (std::size_t)1) + align - 1) / align * align;
+        return std::aligned_alloc(align, rounded);
+    }
+
+    void* allocateOrThrow(std::size_t size)
+    {
+        if (auto* p = allocate(size))
+            return p;
+
+        throw std::bad_alloc();
+    }
+
+    void* allocateAlignedOrThrow(std::size_t size, std::align_val_t alignment)
+    {
+        if (auto* p = allocateAligned(size, alignment))
+            return p;
+
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(std::size_t size) { return allocateOrThrow(size); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAlignedOrThrow(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAlignedOrThrow(size, alignment); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned(size, alignment); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+
+#elif JUCE_WINDOWS && defined (_DEBUG)
+
+namespace
+{
+    int countingAllocHook(int allocType, void*, size_t, int blockType, long, const unsigned char*, int)
+    {
+        //the CRT's own bookkeeping isn't ours
+        if (blockType != _CRT_BLOCK && (allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC))
+            countAllocation();
+
+        return TRUE;
+    }
+
+    struct HookInstaller
+    {
+        HookInstaller() { _CrtSetAllocHook(countingAllocHook); }
+    };
+
+    HookInstaller hookInstaller;
+}
+
+bool Benchmarks::ScopedAllocationCounter::isAvailable() { return true; }
+
+#else
+
+bool Benchmarks::ScopedAllocationCounter::isAvailable() { return false; }
+
+#endif
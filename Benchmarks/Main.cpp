@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+    Runs every SimpleEQ check and micro-benchmark once and prints the results.
+    Exits with 1 if a check failed.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../Source/Benchmarks.h"
+
+namespace
+{
+    struct ConsoleLogger : juce::Logger
+    {
+        void logMessage(const juce::String& message) override
+        {
+            std::cout << message << std::endl;
+        }
+    };
+}
+
+int main()
+{
+    //the editor benchmarks need a message manager, with this thread as the message thread
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    ConsoleLogger logger;
+    juce::Logger::setCurrentLogger(&logger);
+
+    if (!Benchmarks::ScopedAllocationCounter::isAvailable())
+        juce::Logger::writeToLog("[SimpleEQ bench] no allocation hook in this build; allocation counts will be skipped");
+
+    auto passed = Benchmarks::runAll();
+
+    juce::Logger::setCurrentLogger(nullptr);
+    return passed ? 0 : 1;
+}
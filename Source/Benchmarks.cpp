@@ -0,0 +1,880 @@
+#include "Benchmarks.h"
+
+#if SIMPLEEQ_BENCHMARKS
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+#include "FrequencyResponse.h"
+
+namespace Benchmarks
+{
+    namespace
+    {
+        double secondsSince(juce::int64 startTicks)
+        {
+            return juce::Time::highResolutionTicksToSeconds(
+                juce::Time::getHighResolutionTicks() - startTicks);
+        }
+
+        void log(const juce::String& message)
+        {
+            juce::Logger::writeToLog("[SimpleEQ bench] " + message);
+        }
+    }
+
+    InstantiationResult measureInstantiation(int numInstances)
+    {
+        InstantiationResult result;
+
+        juce::MemoryBlock binaryState, legacyState;
+        {
+            SimpleEQAudioProcessor source;
+            source.apvts.getParameter("Peak Gain")->setValueNotifyingHost(0.75f);
+            source.apvts.getParameter("LowCut Slope")->setValueNotifyingHost(1.f);
+            source.getStateInformation(binaryState);
+
+            juce::MemoryOutputStream mos(legacyState, false);
+            source.apvts.copyState().writeToStream(mos);
+        }
+
+        std::vector<std::unique_ptr<SimpleEQAudioProcessor>> instances;
+        instances.reserve((size_t)numInstances);
+
+        auto start = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < numInstances; ++i)
+            instances.push_back(std::make_unique<SimpleEQAudioProcessor>());
+        result.instancesCreatedPerSecond = numInstances / secondsSince(start);
+
+        start = juce::Time::getHighResolutionTicks();
+        for (auto& instance : instances)
+            instance->setStateInformation(binaryState.getData(), (int)binaryState.getSize());
+        result.instancesRestoredPerSecond = numInstances / secondsSince(start);
+
+        start = juce::Time::getHighResolutionTicks();
+        for (auto& instance : instances)
+            instance->setStateInformation(legacyState.getData(), (int)legacyState.getSize());
+        result.legacyInstancesRestoredPerSecond = numInstances / secondsSince(start);
+
+        log("instantiation: " + juce::String(result.instancesCreatedPerSecond, 1) + " instances/s created, "
+            + juce::String(result.instancesRestoredPerSecond, 1) + " instances/s restored (binary), "
+            + juce::String(result.legacyInstancesRestoredPerSecond, 1) + " instances/s restored (ValueTree), "
+            + juce::String((int)binaryState.getSize()) + " vs " + juce::String((int)legacyState.getSize()) + " bytes");
+
+        return result;
+    }
+
+    bool checkStateFormat()
+    {
+        auto passed = true;
+        auto expect = [&passed](bool condition, const juce::String& what)
+        {
+            if (!condition)
+            {
+                log("state format: FAILED, " + what);
+                passed = false;
+            }
+        };
+
+        auto getValues = [](const SimpleEQAudioProcessor& processor)
+        {
+            std::vector<float> values;
+            for (auto* param : processor.getParameters())
+                values.push_back(param->getValue());
+
+            return values;
+        };
+
+        auto sameValues = [](const std::vector<float>& a, const std::vector<float>& b)
+        {
+            return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                [](float x, float y) { return std::abs(x - y) < 1.0e-5f; });
+        };
+
+        //far enough from the defaults that falling back to them can't pass for a restore
+        const std::pair<const char*, float> edits[]
+        {
+            { "LowCut Freq", 0.3f }, { "HighCut Freq", 0.8f }, { "Peak Gain", 0.75f }, { "Peak Quality", 0.4f },
+            { "LowCut Slope", 1.f }, { "Peak Bypassed", 1.f }, { "Analyzer Enabled", 0.f }
+        };
+
+        SimpleEQAudioProcessor source;
+        for (auto [id, value] : edits)
+            source.apvts.getParameter(id)->setValueNotifyingHost(value);
+
+        const auto saved = getValues(source);
+
+        juce::MemoryBlock state;
+        source.getStateInformation(state);
+
+        {
+            SimpleEQAudioProcessor restored;
+            restored.setStateInformation(state.getData(), (int)state.getSize());
+            expect(sameValues(getValues(restored), saved), "binary round trip");
+        }
+
+        {
+            juce::MemoryBlock legacyState;
+            juce::MemoryOutputStream mos(legacyState, false);
+            source.apvts.copyState().writeToStream(mos);
+            mos.flush();
+
+            SimpleEQAudioProcessor restored;
+            restored.setStateInformation(legacyState.getData(), (int)legacyState.getSize());
+            expect(sameValues(getValues(restored), saved), "legacy ValueTree blob");
+        }
+
+        //anything that isn't a whole, intact blob should leave a default processor as it was
+        auto leavesStateAlone = [&getValues, &sameValues](const juce::MemoryBlock& blob)
+        {
+            SimpleEQAudioProcessor target;
+            const auto before = getValues(target);
+            target.setStateInformation(blob.getData(), (int)blob.getSize());
+            return sameValues(getValues(target), before);
+        };
+
+        //the header is magic, version and parameter count, then the values and the checksum
+        auto withWordAt = [&state](size_t offset, juce::uint32 word)
+        {
+            juce::MemoryBlock copy(state);
+            word = juce::ByteOrder::swapIfBigEndian(word);
+            copy.copyFrom(&word, (int)offset, sizeof(word));
+            return copy;
+        };
+
+        for (size_t size = 0; size < state.getSize(); ++size)
+            expect(leavesStateAlone(juce::MemoryBlock(state.getData(), size)), "blob truncated to " + juce::String((int)size) + " bytes");
+
+        {
+            juce::MemoryBlock damaged(state);
+            static_cast<char*>(damaged.getData())[12] ^= 0x40;
+            expect(leavesStateAlone(damaged), "damaged checksum");
+        }
+
+        expect(leavesStateAlone(withWordAt(8, 0x7fffffff)), "parameter count past the end");
+        expect(leavesStateAlone(withWordAt(8, 0x80000000)), "negative parameter count");
+        expect(leavesStateAlone(withWordAt(4, SimpleEQAudioProcessor::stateVersion + 1)), "future version");
+
+        {
+            juce::MemoryBlock foreign;
+            juce::MemoryOutputStream mos(foreign, false);
+            juce::ValueTree("SomeOtherPlugin").setProperty("Peak Gain", 12.0, nullptr).writeToStream(mos);
+            mos.flush();
+            expect(leavesStateAlone(foreign), "another plugin's ValueTree");
+        }
+
+        if (passed)
+            log("state format: all checks passed");
+
+        return passed;
+    }
+
+    bool checkStereoSpectra()
+    {
+        constexpr float toleranceDecibels = 0.01f;
+        constexpr float negativeInfinity = -48.f;
+
+        auto passed = true;
+        juce::Random random(0x5eed);
+
+        for (auto order : { FFTOrder::order2048, FFTOrder::order4096, FFTOrder::order8192 })
+        {
+            const auto fftSize = 1 << order;
+            const auto numBins = fftSize / 2;
+            const auto twoPi = juce::MathConstants<float>::twoPi;
+
+            //noise plus a different tone per channel, so the two spectra can't be mistaken for each other.
+            //the reference channels are left, right, mid and side, worked out sample by sample.
+            juce::AudioBuffer<float> leftRight(2, fftSize), reference(4, fftSize);
+            for (int i = 0; i < fftSize; ++i)
+            {
+                auto t = float(i) / float(fftSize);
+                auto left = 0.5f * (random.nextFloat() * 2.f - 1.f) + 0.5f * std::sin(twoPi * 37.f * t);
+                auto right = 0.5f * (random.nextFloat() * 2.f - 1.f) + 0.25f * std::sin(twoPi * 201.3f * t);
+
+                leftRight.setSample(0, i, left);
+                leftRight.setSample(1, i, right);
+                reference.setSample(0, i, left);
+                reference.setSample(1, i, right);
+                reference.setSample(2, i, 0.5f * (left + right));
+                reference.setSample(3, i, 0.5f * (left - right));
+            }
+
+            juce::AudioBuffer<float> midSide(leftRight);
+            convertToMidSide(midSide.getWritePointer(0), midSide.getWritePointer(1), fftSize);
+
+            auto spectraOf = [order](const juce::AudioBuffer<float>& buffer)
+            {
+                FFTDataGenerator<std::vector<float>> generator;
+                generator.changeOrder(order, buffer.getNumChannels());
+                generator.produceFFTDataForRendering(buffer, negativeInfinity);
+
+                std::vector<float> spectra;
+                generator.getFFTData(spectra);
+                return spectra;
+            };
+
+            auto maxErrorAgainstReference = [&](const juce::AudioBuffer<float>& stereo, int firstReferenceChannel)
+            {
+                auto combined = spectraOf(stereo);
+                auto maxError = 0.f;
+
+                for (int channel = 0; channel < 2; ++channel)
+                {
+                    juce::AudioBuffer<float> single(reference.getArrayOfWritePointers() + firstReferenceChannel + channel, 1, fftSize);
+                    auto separate = spectraOf(single);
+
+                    for (int k = 0; k < numBins; ++k)
+                        maxError = juce::jmax(maxError, std::abs(combined[size_t(channel * numBins + k)] - separate[(size_t)k]));
+                }
+
+                return maxError;
+            };
+
+            auto leftRightError = maxErrorAgainstReference(leftRight, 0);
+            auto midSideError = maxErrorAgainstReference(midSide, 2);
+            auto orderPassed = leftRightError <= toleranceDecibels && midSideError <= toleranceDecibels;
+            passed &= orderPassed;
+
+            log("stereo spectra, order " + juce::String(order) + ": max error "
+                + juce::String(leftRightError, 6) + " dB left/right, "
+                + juce::String(midSideError, 6) + " dB mid/side"
+                + (orderPassed ? "" : ", FAILED: over the " + juce::String(toleranceDecibels) + " dB tolerance"));
+        }
+
+        return passed;
+    }
+
+    std::vector<FFTFrameResult> measureFFTFrames(int numFrames)
+    {
+        std::vector<FFTFrameResult> results;
+        juce::Random random;
+
+        for (auto order : { FFTOrder::order2048, FFTOrder::order4096, FFTOrder::order8192 })
+        {
+            FFTFrameResult result;
+            result.order = order;
+
+            const auto fftSize = 1 << order;
+            const auto numBins = fftSize / 2;
+
+            juce::AudioBuffer<float> input(1, fftSize);
+            for (int i = 0; i < fftSize; ++i)
+                input.setSample(0, i, random.nextFloat() * 2.f - 1.f);
+
+            //the per-bin scalar path FFTDataGenerator used to take
+            {
+                juce::dsp::FFT fft(order);
+                juce::dsp::WindowingFunction<float> window((size_t)fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
+                std::vector<float> fftData((size_t)fftSize * 2);
+
+                auto start = juce::Time::getHighResolutionTicks();
+                for (int frame = 0; frame < numFrames; ++frame)
+                {
+                    fftData.assign(fftData.size(), 0);
+                    std::copy(input.getReadPointer(0), input.getReadPointer(0) + fftSize, fftData.begin());
+                    window.multiplyWithWindowingTable(fftData.data(), (size_t)fftSize);
+                    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+                    for (int i = 0; i < numBins; ++i)
+                    {
+                        auto v = fftData[i];
+                        fftData[i] = (!std::isinf(v) && !std::isnan(v)) ? v / float(numBins) : 0.f;
+                    }
+
+                    for (int i = 0; i < numBins; ++i)
+                        fftData[i] = juce::Decibels::gainToDecibels(fftData[i], -48.f);
+                }
+                result.legacyMicrosecondsPerFrame = secondsSince(start) * 1e6 / numFrames;
+            }
+
+            {
+                FFTDataGenerator<std::vector<float>> generator;
+                generator.changeOrder(order);
+
+                auto start = juce::Time::getHighResolutionTicks();
+                for (int frame = 0; frame < numFrames; ++frame)
+                {
+                    generator.produceFFTDataForRendering(input, -48.f);
+                    if (generator.acquireFFTData() != nullptr)
+                        generator.releaseFFTData();
+                }
+                result.microsecondsPerFrame = secondsSince(start) * 1e6 / numFrames;
+            }
+
+            log("fft frame, order " + juce::String(order) + ": "
+                + juce::String(result.legacyMicrosecondsPerFrame, 2) + " us legacy, "
+                + juce::String(result.microsecondsPerFrame, 2) + " us current");
+
+            results.push_back(result);
+        }
+
+        return results;
+    }
+
+    std::vector<SmoothingResult> measureSmoothing(int numFrames)
+    {
+        std::vector<SmoothingResult> results;
+        juce::Random random;
+
+        constexpr int numColumns = 601;
+        constexpr double sampleRate = 48000;
+
+        for (auto order : { FFTOrder::order2048, FFTOrder::order4096, FFTOrder::order8192 })
+        {
+            const auto numBins = (1 << order) / 2;
+
+            std::vector<float> decibels((size_t)numBins);
+            for (auto& v : decibels)
+                v = -48.f * random.nextFloat();
+
+            SpectrumSmoother smoother;
+            smoother.prepare(numBins);
+
+            for (auto fraction : { AnalyzerSmoothing::ThirdOctave, AnalyzerSmoothing::SixthOctave, AnalyzerSmoothing::TwelfthOctave })
+            {
+                SmoothingResult result;
+                result.order = order;
+                result.fraction = fraction;
+
+                auto binWidth = sampleRate / double(1 << order);
+
+                //the first call builds the column ranges, which a real frame doesn't pay for
+                auto checksum = smoother.process(decibels.data(), numBins, binWidth, fraction, numColumns, -48.f)[0];
+
+                auto start = juce::Time::getHighResolutionTicks();
+                for (int frame = 0; frame < numFrames; ++frame)
+                    checksum += smoother.process(decibels.data(), numBins, binWidth, fraction, numColumns, -48.f)[frame % numColumns];
+                result.microsecondsPerFrame = secondsSince(start) * 1e6 / numFrames;
+
+                log("smoothing, order " + juce::String(order) + ", 1/" + juce::String(fraction) + " octave: "
+                    + juce::String(result.microsecondsPerFrame, 2) + " us (" + juce::String(checksum, 1) + ")");
+
+                results.push_back(result);
+            }
+        }
+
+        return results;
+    }
+
+    std::vector<PathGenerationResult> measurePathGeneration(int numFrames)
+    {
+        std::vector<PathGenerationResult> results;
+        juce::Random random;
+
+        const juce::Rectangle<float> bounds(0, 0, 600, 200);
+        constexpr double sampleRate = 48000;
+
+        juce::Image canvas(juce::Image::PixelFormat::RGB, (int)bounds.getWidth(), (int)bounds.getHeight() + 10, true);
+        juce::Graphics g(canvas);
+        const juce::PathStrokeType stroke(1.f, juce::PathStrokeType::JointStyle::beveled);
+
+        auto map = [&bounds](float v) { return juce::jmap(v, -48.f, 0.f, bounds.getHeight() + 10, bounds.getY()); };
+
+        for (auto order : { FFTOrder::order2048, FFTOrder::order4096, FFTOrder::order8192 })
+        {
+            PathGenerationResult result;
+            result.order = order;
+
+            const auto fftSize = 1 << order;
+            const auto numBins = fftSize / 2;
+            const auto binWidth = float(sampleRate / fftSize);
+
+            std::vector<float> decibels((size_t)numBins);
+            for (auto& v : decibels)
+                v = -48.f * random.nextFloat();
+
+            //the per-bin walk generatePath used to do
+            {
+                juce::Path p;
+                auto start = juce::Time::getHighResolutionTicks();
+                for (int frame = 0; frame < numFrames; ++frame)
+                {
+                    p.clear();
+                    p.startNewSubPath(0, map(decibels[0]));
+                    for (int binNum = 1; binNum < numBins; binNum += 2)
+                    {
+                        auto normalizedBinX = juce::mapFromLog10(binNum * binWidth, 20.f, 20000.f);
+                        p.lineTo(std::floor(normalizedBinX * bounds.getWidth()), map(decibels[(size_t)binNum]));
+                    }
+
+                    g.strokePath(p, stroke);
+                }
+                result.legacyMicrosecondsPerFrame = secondsSince(start) * 1e6 / numFrames;
+
+                for (juce::Path::Iterator it(p); it.next();)
+                    ++result.legacyNumVertices;
+            }
+
+            {
+                AnalyzerPathGenerator<juce::Path> generator;
+                juce::Path p;
+
+                auto start = juce::Time::getHighResolutionTicks();
+                for (int frame = 0; frame < numFrames; ++frame)
+                {
+                    generator.generatePath(decibels.data(), bounds, fftSize, binWidth, -48.f);
+                    generator.swapLatestPath(p);
+                    g.strokePath(p, stroke);
+                }
+                result.microsecondsPerFrame = secondsSince(start) * 1e6 / numFrames;
+
+                for (juce::Path::Iterator it(p); it.next();)
+                    ++result.numVertices;
+            }
+
+            log("path, order " + juce::String(order) + ": "
+                + juce::String(result.legacyMicrosecondsPerFrame, 2) + " us / " + juce::String(result.legacyNumVertices) + " vertices legacy, "
+                + juce::String(result.microsecondsPerFrame, 2) + " us / " + juce::String(result.numVertices) + " vertices current");
+
+            results.push_back(result);
+        }
+
+        return results;
+    }
+
+    TraceRenderingResult measureTraceRendering(int numFrames)
+    {
+        TraceRenderingResult result;
+        juce::Random random;
+
+        const juce::Rectangle<float> bounds(0, 0, 600, 200);
+        const auto fftSize = 1 << FFTOrder::order8192;
+        const auto binWidth = float(48000.0 / fftSize);
+
+        std::array<juce::Path, 2> traces;
+        for (auto& trace : traces)
+        {
+            std::vector<float> decibels((size_t)fftSize / 2);
+            for (auto& v : decibels)
+                v = -48.f * random.nextFloat();
+
+            AnalyzerPathGenerator<juce::Path> generator;
+            generator.generatePath(decibels.data(), bounds, fftSize, binWidth, -48.f);
+            generator.swapLatestPath(trace);
+        }
+
+        juce::Image canvas(juce::Image::PixelFormat::RGB, (int)bounds.getWidth(), (int)bounds.getHeight() + 10, true);
+        juce::Graphics g(canvas);
+
+        {
+            const juce::PathStrokeType stroke(1.f, juce::PathStrokeType::JointStyle::beveled);
+
+            auto start = juce::Time::getHighResolutionTicks();
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                for (auto& trace : traces)
+                {
+                    auto moved = trace;
+                    moved.applyTransform(juce::AffineTransform::translation(0, 5));
+                    g.setColour(juce::Colours::olive);
+                    g.strokePath(moved, stroke);
+                }
+            }
+            result.strokeMicrosecondsPerFrame = secondsSince(start) * 1e6 / numFrames;
+        }
+
+        {
+            TraceRasterizer rasterizer;
+            rasterizer.prepare(canvas.getWidth(), canvas.getHeight(), 1.f);
+
+            auto start = juce::Time::getHighResolutionTicks();
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                rasterizer.beginFrame();
+                for (auto& trace : traces)
+                    rasterizer.drawPolyline(trace, juce::Colours::olive, { 0, 5 });
+
+                rasterizer.draw(g, canvas.getBounds().toFloat());
+            }
+            result.rasterMicrosecondsPerFrame = secondsSince(start) * 1e6 / numFrames;
+        }
+
+        log("traces: " + juce::String(result.strokeMicrosecondsPerFrame, 2) + " us stroked, "
+            + juce::String(result.rasterMicrosecondsPerFrame, 2) + " us rasterized");
+
+        return result;
+    }
+
+    FrequencyResponseResult measureFrequencyResponse(int numRuns)
+    {
+        FrequencyResponseResult result;
+
+        constexpr int numPoints = 1000;
+        constexpr double sampleRate = 48000;
+
+        ChainSettings settings;
+        settings.lowCutFreq = 80.f;
+        settings.highCutFreq = 12000.f;
+        settings.lowCutSlope = Slope::Slope_48;
+        settings.highCutSlope = Slope::Slope_48;
+        settings.peakFreq = 1000.f;
+        settings.peakGainDecibels = 6.f;
+
+        MonoChain chain;
+        updateCoefficients(chain.get<ChainPositions::Peak>().coefficients, makePeakFilter(settings, sampleRate));
+        updateCutFilter(chain.get<ChainPositions::LowCut>(), makeLowCutFilter(settings, sampleRate), settings.lowCutSlope);
+        updateCutFilter(chain.get<ChainPositions::HighCut>(), makeHighCutFilter(settings, sampleRate), settings.highCutSlope);
+
+        std::vector<double> scalar(numPoints), batch(numPoints);
+
+        //the per-section, per-frequency loop ResponseCurveComponent used to run
+        {
+            ResponseSnapshot sections;
+            snapshotChain(chain, sections);
+            result.numSections = (int)sections.size();
+
+            std::vector<Coefficients> coefficients;
+            auto collect = [&coefficients](auto& cut)
+            {
+                coefficients.push_back(cut.template get<0>().coefficients);
+                coefficients.push_back(cut.template get<1>().coefficients);
+                coefficients.push_back(cut.template get<2>().coefficients);
+                coefficients.push_back(cut.template get<3>().coefficients);
+            };
+            collect(chain.get<ChainPositions::LowCut>());
+            coefficients.push_back(chain.get<ChainPositions::Peak>().coefficients);
+            collect(chain.get<ChainPositions::HighCut>());
+
+            auto start = juce::Time::getHighResolutionTicks();
+            for (int run = 0; run < numRuns; ++run)
+            {
+                for (int i = 0; i < numPoints; ++i)
+                {
+                    auto freq = juce::mapToLog10(double(i) / double(numPoints), 20.0, 20000.0);
+                    double mag = 1;
+                    for (auto& c : coefficients)
+                        mag *= c->getMagnitudeForFrequency(freq, sampleRate);
+
+                    scalar[(size_t)i] = juce::Decibels::gainToDecibels(mag);
+                }
+            }
+            result.scalarMicroseconds = secondsSince(start) * 1e6 / numRuns;
+        }
+
+        {
+            FrequencyResponseEvaluator evaluator;
+            ResponseSnapshot sections;
+
+            auto start = juce::Time::getHighResolutionTicks();
+            for (int run = 0; run < numRuns; ++run)
+            {
+                evaluator.setLogGrid(numPoints, 20.0, 20000.0, sampleRate);
+                snapshotChain(chain, sections);
+                evaluator.computeDecibels(sections, batch.data());
+            }
+            result.batchMicroseconds = secondsSince(start) * 1e6 / numRuns;
+        }
+
+        for (int i = 0; i < numPoints; ++i)
+            result.maxErrorDecibels = juce::jmax(result.maxErrorDecibels, std::abs(scalar[(size_t)i] - batch[(size_t)i]));
+
+        result.withinTolerance = result.maxErrorDecibels <= FrequencyResponseResult::toleranceDecibels;
+
+        log("frequency response, " + juce::String(result.numSections) + " sections: "
+            + juce::String(result.scalarMicroseconds, 2) + " us scalar, "
+            + juce::String(result.batchMicroseconds, 2) + " us batch, max error "
+            + juce::String(result.maxErrorDecibels, 6) + " dB"
+            + (result.withinTolerance ? "" : ", FAILED: over the " + juce::String(FrequencyResponseResult::toleranceDecibels) + " dB tolerance"));
+
+        return result;
+    }
+
+    KnobRenderingResult measureKnobRendering(int numFrames)
+    {
+        KnobRenderingResult result;
+
+        SimpleEQAudioProcessor processor;
+        RotarySliderWithLabels slider(*processor.apvts.getParameter("Peak Freq"), "Hz");
+        slider.setBounds(0, 0, 148, 160);
+
+        const auto bounds = slider.getSliderBounds();
+        const auto startAng = juce::degreesToRadians(180.f + 45.f);
+        const auto endAng = juce::degreesToRadians(180.f - 45.f) + juce::MathConstants<float>::twoPi;
+
+        juce::Image canvas(juce::Image::PixelFormat::ARGB, slider.getWidth(), slider.getHeight(), true);
+        juce::Graphics g(canvas);
+
+        auto position = [numFrames](int frame) { return float(frame % numFrames) / float(numFrames); };
+
+        //what LookAndFeel::drawRotarySlider did on every repaint
+        {
+            using namespace juce;
+
+            auto start = Time::getHighResolutionTicks();
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                auto r = bounds.toFloat();
+                auto center = r.getCentre();
+
+                g.setColour(Colour(97u, 18u, 167u));
+                g.fillEllipse(r);
+                g.setColour(Colour(255u, 155u, 1u));
+                g.drawEllipse(r, 1.f);
+
+                Path p;
+                Rectangle<float> pointer;
+                pointer.setLeft(center.getX() - 2);
+                pointer.setRight(center.getX() + 2);
+                pointer.setTop(r.getY());
+                pointer.setBottom(center.getY() - slider.getTextHeight() * 1.5);
+                p.addRoundedRectangle(pointer, 2.f);
+                p.applyTransform(AffineTransform().rotated(jmap(position(frame), startAng, endAng), center.getX(), center.getY()));
+                g.fillPath(p);
+
+                g.setFont(slider.getTextHeight());
+                auto text = slider.getDisplayString();
+                pointer.setSize(g.getCurrentFont().getStringWidth(text) + 4.f, slider.getTextHeight() + 2.f);
+                pointer.setCentre(center);
+                g.setColour(Colours::rebeccapurple);
+                g.fillRect(pointer);
+                g.setColour(Colours::white);
+                g.drawFittedText(text, pointer.toNearestInt(), Justification::centred, 1);
+            }
+            result.legacyMicrosecondsPerKnob = secondsSince(start) * 1e6 / numFrames;
+        }
+
+        {
+            auto& lnf = slider.getLookAndFeel();
+            auto draw = [&](int frame)
+            {
+                lnf.drawRotarySlider(g, bounds.getX(), bounds.getY(), bounds.getWidth(), bounds.getHeight(),
+                    position(frame), startAng, endAng, slider);
+            };
+
+            //fills the strip, as a sweep through the whole range would
+            for (int frame = 0; frame < numFrames; ++frame)
+                draw(frame);
+
+            auto start = juce::Time::getHighResolutionTicks();
+            for (int frame = 0; frame < numFrames; ++frame)
+                draw(frame);
+            result.microsecondsPerKnob = secondsSince(start) * 1e6 / numFrames;
+        }
+
+        log("knobs: " + juce::String(result.legacyMicrosecondsPerKnob, 2) + " us drawn, "
+            + juce::String(result.microsecondsPerKnob, 2) + " us from the filmstrip");
+
+        return result;
+    }
+
+    FrameAllocationResult measureFrameAllocations(int numFrames)
+    {
+        FrameAllocationResult result;
+        result.numFrames = numFrames;
+
+        //a zero means nothing unless the counter is seen to fire. the pointers escape
+        //through 'sink' so the compiler can't drop the allocations.
+        {
+            static std::atomic<void*> sink{ nullptr };
+
+            ScopedAllocationCounter counter;
+
+            juce::HeapBlock<float> block(256);
+            sink.store(block.get());
+            block.realloc(4096);
+            sink.store(block.get());
+
+            auto boxed = std::make_unique<double>(1.0);
+            sink.store(boxed.get());
+
+            result.counterVerified = counter.getCount() >= 3;
+        }
+
+        if (!result.counterVerified)
+        {
+            log("frame allocations: the allocation counter didn't fire in this build, so there is nothing to report");
+            return result;
+        }
+
+        constexpr double sampleRate = 48000;
+        constexpr int blockSize = 512;
+        const juce::Rectangle<float> bounds(0, 0, 600, 200);
+
+        SimpleEQAudioProcessor processor;
+        processor.setAnalyzerTapActive(true);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        PathProducer producer(processor.leftChannelFifo, processor.rightChannelFifo);
+        producer.allocate();
+        producer.setOrder(FFTOrder::order2048);
+
+        TraceRasterizer rasterizer;
+        rasterizer.prepare((int)bounds.getWidth(), (int)bounds.getHeight(), 1.f);
+
+        juce::AudioBuffer<float> block(2, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random;
+
+        //one editor frame's worth of audio per frame, as at 60 Hz
+        auto runFrame = [&](juce::int64& analysisAllocations, juce::int64& rasterAllocations)
+        {
+            for (int ch = 0; ch < block.getNumChannels(); ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                    block.setSample(ch, i, random.nextFloat() * 2.f - 1.f);
+
+            processor.processBlock(block, midi);
+
+            {
+                ScopedAllocationCounter counter;
+                producer.process(bounds, sampleRate);
+                producer.pullLatestPaths();
+                analysisAllocations += counter.getCount();
+            }
+
+            {
+                ScopedAllocationCounter counter;
+                rasterizer.beginFrame();
+                rasterizer.drawPolyline(producer.getPath(0), juce::Colours::olive, {});
+                rasterizer.drawPolyline(producer.getPath(1), juce::Colours::olivedrab, {});
+                rasterAllocations += counter.getCount();
+            }
+        };
+
+        //every fifo slot and path buffer has to have been used once before it stops growing
+        for (auto engine : { AnalyzerEngine::FFT, AnalyzerEngine::ConstantQ })
+        {
+            producer.setEngine(engine);
+
+            for (auto smoothing : { AnalyzerSmoothing::NoSmoothing, AnalyzerSmoothing::SixthOctave })
+            {
+                producer.setSmoothing(smoothing);
+
+                juce::int64 ignored = 0;
+                for (int frame = 0; frame < 200; ++frame)
+                    runFrame(ignored, ignored);
+
+                for (int frame = 0; frame < numFrames; ++frame)
+                    runFrame(result.analysisAllocations, result.rasterAllocations);
+            }
+        }
+
+        producer.release();
+        processor.setAnalyzerTapActive(false);
+
+        //now the whole component, driven here instead of by the timer and the scheduler so every frame is counted
+        {
+            SimpleEQAudioProcessor editorProcessor;
+            editorProcessor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+            editorProcessor.prepareToPlay(sampleRate, blockSize);
+
+            ResponseCurveComponent component(editorProcessor);
+            component.setBounds(0, 0, 600, 300);
+
+            juce::Image canvas(juce::Image::PixelFormat::ARGB, component.getWidth(), component.getHeight(), true, juce::SoftwareImageType());
+            juce::Graphics g(canvas);
+
+            //the analyzer attaches after the first paint; then it comes off the scheduler, so nothing runs it but us
+            juce::SharedResourcePointer<AnalysisScheduler> scheduler;
+            component.paint(g);
+            component.toggleAnalysisEnablement(true);
+
+            auto runComponentFrame = [&](juce::int64& allocations)
+            {
+                for (int ch = 0; ch < block.getNumChannels(); ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                        block.setSample(ch, i, random.nextFloat() * 2.f - 1.f);
+
+                editorProcessor.processBlock(block, midi);
+
+                ScopedAllocationCounter counter;
+                component.runAnalysisFrame();
+                component.pullAnalysis();
+                component.paint(g);
+                allocations += counter.getCount();
+            };
+
+            for (auto engine : { AnalyzerEngine::FFT, AnalyzerEngine::ConstantQ })
+            {
+                component.setAnalyzerEngine(engine);
+
+                for (auto view : { AnalyzerView::Lines, AnalyzerView::Spectrogram })
+                {
+                    component.setAnalyzerView(view);
+                    scheduler->removeClient(&component);
+
+                    juce::int64 ignored = 0;
+                    for (int frame = 0; frame < 200; ++frame)
+                        runComponentFrame(ignored);
+
+                    for (int frame = 0; frame < numFrames; ++frame)
+                        runComponentFrame(result.componentAllocations);
+                }
+            }
+        }
+
+        log("frame allocations over " + juce::String(numFrames * 4) + " frames each: "
+            + juce::String(result.analysisAllocations) + " in analysis, "
+            + juce::String(result.rasterAllocations) + " in rasterizing, "
+            + juce::String(result.componentAllocations) + " in whole component frames"
+            + (result.isAllocationFree() ? "" : ", FAILED: expected none"));
+
+        return result;
+    }
+
+    EditorOpenResult measureEditorOpen(int numOpens)
+    {
+        EditorOpenResult result;
+        result.numOpens = numOpens;
+
+        if (numOpens <= 0)
+            return result;
+
+        SimpleEQAudioProcessor processor;
+        processor.prepareToPlay(48000, 512);
+
+        std::vector<double> milliseconds;
+        milliseconds.reserve((size_t)numOpens);
+
+        for (int i = 0; i < numOpens; ++i)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+
+            std::unique_ptr<juce::AudioProcessorEditor> editor(processor.createEditor());
+            editor->createComponentSnapshot(editor->getLocalBounds());
+
+            milliseconds.push_back(secondsSince(start) * 1e3);
+        }
+
+        std::sort(milliseconds.begin(), milliseconds.end());
+
+        auto percentile = [&milliseconds](double p)
+        {
+            auto index = (size_t)juce::jlimit(0, (int)milliseconds.size() - 1,
+                (int)std::ceil(p * milliseconds.size()) - 1);
+            return milliseconds[index];
+        };
+
+        result.medianMilliseconds = percentile(0.5);
+        result.p99Milliseconds = percentile(0.99);
+
+        log("editor open: " + juce::String(result.medianMilliseconds, 2) + " ms median, "
+            + juce::String(result.p99Milliseconds, 2) + " ms p99 to first frame over "
+            + juce::String(numOpens) + " opens");
+
+        return result;
+    }
+
+    bool runAll()
+    {
+        auto passed = checkStateFormat();
+        passed &= checkStereoSpectra();
+
+        measureInstantiation();
+        measureFFTFrames();
+        measureSmoothing();
+        measurePathGeneration();
+        measureTraceRendering();
+        passed &= measureFrequencyResponse().withinTolerance;
+        measureKnobRendering();
+
+        auto frameAllocations = measureFrameAllocations();
+        if (frameAllocations.counterVerified)
+            passed &= frameAllocations.isAllocationFree();
+
+        measureEditorOpen();
+
+        return passed;
+    }
+}
+
+#endif
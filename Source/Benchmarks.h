@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    Micro-benchmarks for the processor and editor hot paths.
+
+    Built and run by the console project in Benchmarks/SimpleEQBenchmarks.jucer,
+    which sets SIMPLEEQ_BENCHMARKS to 1 and links the allocation hooks the
+    counters below rely on. The plugin never defines it. Results are written
+    to the juce::Logger, and the checks make the runner exit non-zero on failure.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef SIMPLEEQ_BENCHMARKS
+ #define SIMPLEEQ_BENCHMARKS 0
+#endif
+
+#if SIMPLEEQ_BENCHMARKS && defined (JucePlugin_Build_VST3)
+ #error "the benchmarks replace the process allocator; build Benchmarks/SimpleEQBenchmarks.jucer instead of enabling them in the plugin"
+#endif
+
+#if SIMPLEEQ_BENCHMARKS
+
+namespace Benchmarks
+{
+    /*
+     counts heap allocations made on the constructing thread while in scope:
+     malloc, calloc and realloc (which juce::HeapBlock uses under Path,
+     AudioBuffer, Array and Image) as well as every form of operator new.
+     the hooks live in Benchmarks/AllocationCounter.cpp. where the platform
+     offers none, isAvailable() is false and the count stays at zero.
+     */
+    struct ScopedAllocationCounter
+    {
+        ScopedAllocationCounter();
+        ~ScopedAllocationCounter();
+
+        juce::int64 getCount() const;
+
+        static bool isAvailable();
+    };
+
+    struct InstantiationResult
+    {
+        double instancesCreatedPerSecond{ 0 };
+        double instancesRestoredPerSecond{ 0 };
+        double legacyInstancesRestoredPerSecond{ 0 };
+    };
+
+    /** creates and restores numInstances processors, like loading a large session */
+    InstantiationResult measureInstantiation(int numInstances = 400);
+
+    /** a binary round trip and a legacy ValueTree blob must restore the saved values; every truncation of a blob,
+        a damaged checksum, a parameter count past the end, a future version and a foreign blob must all leave the
+        current state alone. logs each case that doesn't and returns false. */
+    bool checkStateFormat();
+
+    struct FFTFrameResult
+    {
+        int order{ 0 };
+        double legacyMicrosecondsPerFrame{ 0 };
+        double microsecondsPerFrame{ 0 };
+    };
+
+    /** FFTDataGenerator's two-for-one complex transform against a real transform per channel, on random left/right
+        input and on its mid/side conversion, orders 11-13. logs the largest difference and returns false if any bin
+        is off by more than 0.01 dB. */
+    bool checkStereoSpectra();
+
+    /** window + transform + dB conversion per frame, old scalar path vs FFTDataGenerator, orders 11-13 */
+    std::vector<FFTFrameResult> measureFFTFrames(int numFrames = 2000);
+
+    struct SmoothingResult
+    {
+        int order{ 0 };
+        int fraction{ 0 };
+        double microsecondsPerFrame{ 0 };
+    };
+
+    /** SpectrumSmoother cost per channel per frame at 1/3, 1/6 and 1/12 octave, orders 11-13, 600 columns */
+    std::vector<SmoothingResult> measureSmoothing(int numFrames = 2000);
+
+    struct PathGenerationResult
+    {
+        int order{ 0 };
+        int legacyNumVertices{ 0 };
+        int numVertices{ 0 };
+        double legacyMicrosecondsPerFrame{ 0 };
+        double microsecondsPerFrame{ 0 };
+    };
+
+    /** path build + stroke into a 600 px wide image, per-bin lineTo vs per-column min/max, orders 11-13 */
+    std::vector<PathGenerationResult> measurePathGeneration(int numFrames = 500);
+
+    struct TraceRenderingResult
+    {
+        double strokeMicrosecondsPerFrame{ 0 };
+        double rasterMicrosecondsPerFrame{ 0 };
+    };
+
+    /** two order-13 analyzer traces in a 600 x 200 area, strokePath vs TraceRasterizer */
+    TraceRenderingResult measureTraceRendering(int numFrames = 500);
+
+    struct FrequencyResponseResult
+    {
+        //both paths evaluate the same float coefficients in double, so only rounding should separate them
+        static constexpr double toleranceDecibels = 1.0e-4;
+
+        int numSections{ 0 };
+        double scalarMicroseconds{ 0 };
+        double batchMicroseconds{ 0 };
+        double maxErrorDecibels{ 0 };
+        bool withinTolerance{ false };
+    };
+
+    /** magnitude of the whole chain (both cuts at 48 dB/oct + peak) over 1000 log-spaced points, per call.
+        withinTolerance is only set if the batch result matches the per-section one to toleranceDecibels everywhere. */
+    FrequencyResponseResult measureFrequencyResponse(int numRuns = 500);
+
+    struct KnobRenderingResult
+    {
+        double legacyMicrosecondsPerKnob{ 0 };
+        double microsecondsPerKnob{ 0 };
+    };
+
+    /** one 120 px knob body, pointer and value text, path-drawn vs filmstrip blit, once every frame has been cached */
+    KnobRenderingResult measureKnobRendering(int numFrames = 2000);
+
+    struct FrameAllocationResult
+    {
+        int numFrames{ 0 };
+        bool counterVerified{ false };
+        juce::int64 analysisAllocations{ 0 };
+        juce::int64 rasterAllocations{ 0 };
+        juce::int64 componentAllocations{ 0 };
+
+        bool isAllocationFree() const { return analysisAllocations + rasterAllocations + componentAllocations == 0; }
+    };
+
+    /** heap allocations over numFrames steady-state frames (after a warm-up) per engine and view. a PathProducer's
+        analysis and the trace rasterizing are counted on their own, then a whole ResponseCurveComponent frame:
+        analysis, the timer's pull and a full paint into an image, in both the lines and spectrogram views.
+        all should be zero. counterVerified is only set once a deliberate allocation has been seen to register. */
+    FrameAllocationResult measureFrameAllocations(int numFrames = 1000);
+
+    struct EditorOpenResult
+    {
+        int numOpens{ 0 };
+        double medianMilliseconds{ 0 };
+        double p99Milliseconds{ 0 };
+    };
+
+    /** time from constructing an editor to its first full frame (a snapshot of the whole hierarchy), opened and
+        closed numOpens times in a row. message thread only. */
+    EditorOpenResult measureEditorOpen(int numOpens = 100);
+
+    /** runs every check and benchmark. returns false if any check failed. */
+    bool runAll();
+}
+
+#endif
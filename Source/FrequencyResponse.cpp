@@ -0,0 +1,173 @@
+#include "FrequencyResponse.h"
+
+namespace
+{
+    void snapshotFilter(const Filter& filter, ResponseSnapshot& snapshot)
+    {
+        const auto& c = filter.coefficients->coefficients;
+
+        //raw layout is b0..bN, a1..aN with a0 normalised away
+        if (c.size() == 5)
+            snapshot.push_back({ c[0], c[1], c[2], c[3], c[4] });
+        else if (c.size() == 3)
+            snapshot.push_back({ c[0], c[1], 0, c[2], 0 });
+        else
+            jassertfalse; //only first and second order sections are used here
+    }
+
+    template<int Index>
+    void snapshotCutStage(const CutFilter& cut, ResponseSnapshot& snapshot)
+    {
+        if (!cut.isBypassed<Index>())
+            snapshotFilter(cut.get<Index>(), snapshot);
+    }
+
+    void snapshotCut(const CutFilter& cut, ResponseSnapshot& snapshot)
+    {
+        snapshotCutStage<0>(cut, snapshot);
+        snapshotCutStage<1>(cut, snapshot);
+        snapshotCutStage<2>(cut, snapshot);
+        snapshotCutStage<3>(cut, snapshot);
+    }
+}
+
+void snapshotChain(const MonoChain& chain, ResponseSnapshot& snapshot)
+{
+    snapshot.clear();
+
+    if (!chain.isBypassed<ChainPositions::LowCut>())
+        snapshotCut(chain.get<ChainPositions::LowCut>(), snapshot);
+
+    if (!chain.isBypassed<ChainPositions::Peak>())
+        snapshotFilter(chain.get<ChainPositions::Peak>(), snapshot);
+
+    if (!chain.isBypassed<ChainPositions::HighCut>())
+        snapshotCut(chain.get<ChainPositions::HighCut>(), snapshot);
+}
+
+void FrequencyResponseEvaluator::allocate(int numFrequencies)
+{
+    for (auto* table : { &cosW, &sinW, &cos2W, &sin2W, &realPart, &imagPart, &denReal, &denImag })
+        table->resize((size_t)numFrequencies);
+}
+
+void FrequencyResponseEvaluator::setGrid(const double* frequencies, int numFrequencies, double sampleRate)
+{
+    jassert(sampleRate > 0);
+
+    allocate(numFrequencies);
+    gridSampleRate = sampleRate;
+    gridIsLog = false;
+
+    for (int i = 0; i < numFrequencies; ++i)
+    {
+        auto w = juce::MathConstants<double>::twoPi * frequencies[i] / sampleRate;
+        cosW[i] = std::cos(w);
+        sinW[i] = std::sin(w);
+        cos2W[i] = std::cos(2 * w);
+        sin2W[i] = std::sin(2 * w);
+    }
+}
+
+void FrequencyResponseEvaluator::setLogGrid(int numFrequencies, double minHz, double maxHz, double sampleRate)
+{
+    if (gridIsLog && numFrequencies == getNumFrequencies() && sampleRate == gridSampleRate
+        && minHz == gridMinHz && maxHz == gridMaxHz)
+        return;
+
+    //fill the first table with the frequencies, then turn them into trig in place
+    allocate(numFrequencies);
+    for (int i = 0; i < numFrequencies; ++i)
+        realPart[i] = juce::mapToLog10(double(i) / double(numFrequencies), minHz, maxHz);
+
+    setGrid(realPart.data(), numFrequencies, sampleRate);
+
+    gridIsLog = true;
+    gridMinHz = minHz;
+    gridMaxHz = maxHz;
+}
+
+void FrequencyResponseEvaluator::computeDecibels(const ResponseSnapshot& sections, double* decibels, double minusInfinityDb)
+{
+    const auto n = getNumFrequencies();
+    auto* __restrict powers = realPart.data();
+
+    std::fill(powers, powers + n, 1.0);
+
+    const auto* __restrict c1 = cosW.data();
+    const auto* __restrict s1 = sinW.data();
+    const auto* __restrict c2 = cos2W.data();
+    const auto* __restrict s2 = sin2W.data();
+
+    //|H|^2 = product over sections of |N(z)|^2 / |D(z)|^2, with z^-k = cos kw - j sin kw
+    for (const auto& s : sections)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            auto nr = s.b0 + s.b1 * c1[i] + s.b2 * c2[i];
+            auto ni = s.b1 * s1[i] + s.b2 * s2[i];
+            auto dr = 1.0 + s.a1 * c1[i] + s.a2 * c2[i];
+            auto di = s.a1 * s1[i] + s.a2 * s2[i];
+
+            powers[i] *= (nr * nr + ni * ni) / (dr * dr + di * di);
+        }
+    }
+
+    //10 log10 of the power is 20 log10 of the magnitude
+    const auto minPower = std::pow(10.0, minusInfinityDb / 10.0);
+    for (int i = 0; i < n; ++i)
+        decibels[i] = powers[i] > minPower ? 10.0 * std::log10(powers[i]) : minusInfinityDb;
+}
+
+void FrequencyResponseEvaluator::computeMagnitudeAndPhase(const ResponseSnapshot& sections, double* magnitudes, double* phases)
+{
+    const auto n = getNumFrequencies();
+    auto* __restrict nRe = realPart.data();
+    auto* __restrict nIm = imagPart.data();
+    auto* __restrict dRe = denReal.data();
+    auto* __restrict dIm = denImag.data();
+
+    std::fill(nRe, nRe + n, 1.0);
+    std::fill(nIm, nIm + n, 0.0);
+    std::fill(dRe, dRe + n, 1.0);
+    std::fill(dIm, dIm + n, 0.0);
+
+    const auto* __restrict c1 = cosW.data();
+    const auto* __restrict s1 = sinW.data();
+    const auto* __restrict c2 = cos2W.data();
+    const auto* __restrict s2 = sin2W.data();
+
+    //numerators and denominators are multiplied up separately so there's one division and one atan2 per point
+    for (const auto& s : sections)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            auto nr = s.b0 + s.b1 * c1[i] + s.b2 * c2[i];
+            auto ni = -(s.b1 * s1[i] + s.b2 * s2[i]);
+            auto dr = 1.0 + s.a1 * c1[i] + s.a2 * c2[i];
+            auto di = -(s.a1 * s1[i] + s.a2 * s2[i]);
+
+            auto re = nRe[i] * nr - nIm[i] * ni;
+            nIm[i] = nRe[i] * ni + nIm[i] * nr;
+            nRe[i] = re;
+
+            re = dRe[i] * dr - dIm[i] * di;
+            dIm[i] = dRe[i] * di + dIm[i] * dr;
+            dRe[i] = re;
+        }
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        //H = N / D = N * conj(D) / |D|^2
+        auto denPower = dRe[i] * dRe[i] + dIm[i] * dIm[i];
+        auto hr = (nRe[i] * dRe[i] + nIm[i] * dIm[i]) / denPower;
+        auto hi = (nIm[i] * dRe[i] - nRe[i] * dIm[i]) / denPower;
+
+        if (magnitudes != nullptr)
+            magnitudes[i] = std::sqrt(hr * hr + hi * hi);
+
+        if (phases != nullptr)
+            phases[i] = std::atan2(hi, hr);
+    }
+}
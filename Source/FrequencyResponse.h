@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    Batch magnitude/phase response of the EQ's filter sections.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+/** one section's normalised coefficients: (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2) */
+struct BiquadSnapshot
+{
+    double b0, b1, b2, a1, a2;
+};
+
+using ResponseSnapshot = std::vector<BiquadSnapshot>;
+
+/**
+ copies the coefficients of every section of 'chain' that isn't bypassed into
+ 'snapshot'. first-order sections get zero b2 and a2. reuses the snapshot's
+ storage, so a warm snapshot doesn't allocate.
+ */
+void snapshotChain(const MonoChain& chain, ResponseSnapshot& snapshot);
+
+/*
+ evaluates the combined response of a set of sections over a fixed frequency
+ grid. the sin/cos of w and 2w are worked out once per grid, and each section
+ is then a pass of multiply-adds over structure-of-arrays tables, which the
+ compiler vectorises. replaces one Coefficients::getMagnitudeForFrequency call,
+ with its own trig, per section per frequency.
+ */
+struct FrequencyResponseEvaluator
+{
+    /** rebuilds the trig tables for an arbitrary grid */
+    void setGrid(const double* frequencies, int numFrequencies, double sampleRate);
+
+    /**
+     numFrequencies log-spaced points, frequency i at mapToLog10(i / numFrequencies, minHz, maxHz).
+     returns straight away when the grid hasn't changed, so it can be called before every evaluation.
+     */
+    void setLogGrid(int numFrequencies, double minHz, double maxHz, double sampleRate);
+
+    int getNumFrequencies() const { return (int)cosW.size(); }
+
+    /** magnitude in dB, floored at minusInfinityDb like Decibels::gainToDecibels */
+    void computeDecibels(const ResponseSnapshot& sections, double* decibels, double minusInfinityDb = -100.0);
+
+    /** linear magnitude and phase in radians; either output may be null */
+    void computeMagnitudeAndPhase(const ResponseSnapshot& sections, double* magnitudes, double* phases);
+
+private:
+    //cos/sin of w and 2w per grid point
+    std::vector<double> cosW, sinW, cos2W, sin2W;
+
+    //per-point scratch for the products over the sections
+    std::vector<double> realPart, imagPart, denReal, denImag;
+
+    double gridSampleRate = 0;
+    double gridMinHz = 0, gridMaxHz = 0;
+    bool gridIsLog = false;
+
+    void allocate(int numFrequencies);
+};
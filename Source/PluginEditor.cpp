@@ -1,6 +1,113 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+juce::Image KnobFilmstripCache::renderFrame(const Style& style, float angle)
+{
+    using namespace juce;
+
+    //a pixel of margin so the outline's outer half isn't clipped
+    auto size = roundToInt((style.diameter + 2) * style.scale);
+    Image frame(Image::PixelFormat::ARGB, size, size, true, SoftwareImageType());
+
+    Graphics g(frame);
+    g.addTransform(AffineTransform::scale(style.scale));
+
+    auto bounds = Rectangle<float>(1.f, 1.f, (float)style.diameter, (float)style.diameter);
+
+    g.setColour(style.enabled ? Colour(97u, 18u, 167u) : Colours::darkgrey);
+    g.fillEllipse(bounds);
+
+    g.setColour(style.enabled ? Colour(255u, 155u, 1u) : Colours::darkseagreen);
+    g.drawEllipse(bounds, 1.f);
+
+    auto center = bounds.getCentre();
+
+    Path p;
+
+    Rectangle<float> r;
+    r.setLeft(center.getX() - 2);
+    r.setRight(center.getX() + 2);
+    r.setTop(bounds.getY());
+    r.setBottom(center.getY() - style.pointerInset);
+
+    p.addRoundedRectangle(r, 2.f);
+    p.applyTransform(AffineTransform().rotated(angle, center.getX(), center.getY()));
+
+    g.fillPath(p);
+
+    return frame;
+}
+
+KnobFilmstripCache::Strip& KnobFilmstripCache::getStrip(const Style& style)
+{
+    for (auto& strip : strips)
+        if (strip->style == style)
+            return *strip;
+
+    auto& strip = strips.emplace_back(std::make_unique<Strip>());
+    strip->style = style;
+
+    return *strip;
+}
+
+size_t KnobFilmstripCache::getFrameBytes(const juce::Image& image)
+{
+    return (size_t)image.getWidth() * (size_t)image.getHeight() * 4;
+}
+
+void KnobFilmstripCache::evictUntilWithinBudget(const Frame& frameInUse)
+{
+    //only runs when a frame was just rendered, so a scan over every frame is fine
+    while (bytesUsed > maxBytes)
+    {
+        Frame* oldest = nullptr;
+
+        for (auto& strip : strips)
+            for (auto& frame : strip->frames)
+                if (frame.image.isValid() && &frame != &frameInUse
+                    && (oldest == nullptr || frame.lastUsed < oldest->lastUsed))
+                    oldest = &frame;
+
+        if (oldest == nullptr)
+            break;
+
+        bytesUsed -= getFrameBytes(oldest->image);
+        oldest->image = juce::Image();
+    }
+
+    //sizes and scales that are no longer shown leave empty strips behind
+    strips.erase(std::remove_if(strips.begin(), strips.end(), [](const auto& strip)
+        {
+            return std::none_of(strip->frames.begin(), strip->frames.end(),
+                [](const Frame& frame) { return frame.image.isValid(); });
+        }),
+        strips.end());
+}
+
+void KnobFilmstripCache::draw(juce::Graphics& g, juce::Rectangle<int> bounds, const Style& style, float sliderPosProportional)
+{
+    if (style.diameter <= 0)
+        return;
+
+    auto& strip = getStrip(style);
+
+    auto index = juce::roundToInt(juce::jlimit(0.f, 1.f, sliderPosProportional) * (numFrames - 1));
+    auto& frame = strip.frames[(size_t)index];
+    frame.lastUsed = ++useCounter;
+
+    if (!frame.image.isValid())
+    {
+        auto angle = juce::jmap(index / float(numFrames - 1), style.startAngle, style.endAngle);
+        frame.image = renderFrame(style, angle);
+        bytesUsed += getFrameBytes(frame.image);
+
+        evictUntilWithinBudget(frame);
+    }
+
+    //the frame is at physical resolution, so this is a 1:1 copy
+    g.drawImage(frame.image, bounds.expanded(1).toFloat());
+}
+
 void LookAndFeel::drawRotarySlider(juce::Graphics& g,
     int x,
     int y,
@@ -17,47 +124,44 @@ void LookAndFeel::drawRotarySlider(juce::Graphics& g,
 
     auto enabled = slider.isEnabled();
 
-    g.setColour(enabled ? Colour(97u, 18u, 167u) : Colours::darkgrey);
-    g.fillEllipse(bounds);
-    
-    g.setColour(enabled ? Colour(255u, 155u, 1u) : Colours::darkseagreen);
-    g.drawEllipse(bounds, 1.f);
-
     if (auto* rswl = dynamic_cast<RotarySliderWithLabels*>(&slider))
     {
-        auto center = bounds.getCentre();
-
-        Path p;
-
-        Rectangle<float> r;
-        r.setLeft(center.getX() - 2);
-        r.setRight(center.getX() + 2);
-        r.setTop(bounds.getY());
-        r.setBottom(center.getY() - rswl->getTextHeight() * 1.5);
-
-        p.addRoundedRectangle(r, 2.f);
-        //p.addRectangle(r);
-
         jassert(rotaryStartAngle < rotaryEndAngle);
 
-        auto sliderAngRad = jmap(sliderPositionProportional, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
+        //the disc and pointer come pre-rendered; only the value text is drawn live
+        KnobFilmstripCache::Style style;
+        style.diameter = jmin(width, height);
+        style.scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        style.enabled = enabled;
+        style.pointerInset = rswl->getTextHeight() * 1.5f;
+        style.startAngle = rotaryStartAngle;
+        style.endAngle = rotaryEndAngle;
 
-        p.applyTransform(AffineTransform().rotated(sliderAngRad, center.getX(), center.getY()));
+        knobFilmstrips.draw(g, { x, y, style.diameter, style.diameter }, style, sliderPositionProportional);
 
-        g.fillPath(p);
+        auto center = bounds.getCentre();
 
         g.setFont(rswl->getTextHeight());
         auto text = rswl->getDisplayString();
         auto strWidth = g.getCurrentFont().getStringWidth(text);
 
+        Rectangle<float> r;
         r.setSize(strWidth + 4.f, rswl->getTextHeight() + 2.f);
         r.setCentre(center);
         g.setColour(juce::Colours::rebeccapurple);
         g.fillRect(r);
 
         g.setColour(Colours::white);
-        g.drawFittedText(text, r.toNearestInt(), juce::Justification::centred, 1);
+        g.drawText(text, r, juce::Justification::centred, false);
+
+        return;
     }
+
+    g.setColour(enabled ? Colour(97u, 18u, 167u) : Colours::darkgrey);
+    g.fillEllipse(bounds);
+    
+    g.setColour(enabled ? Colour(255u, 155u, 1u) : Colours::darkseagreen);
+    g.drawEllipse(bounds, 1.f);
 }
 
 void LookAndFeel::drawToggleButton(juce::Graphics& g,
@@ -129,6 +233,157 @@ void LookAndFeel::drawToggleButton(juce::Graphics& g,
     }
 }
 
+bool TraceRasterizer::prepare(int width, int height, float scaleFactor)
+{
+    auto physicalWidth = juce::roundToInt(width * scaleFactor);
+    auto physicalHeight = juce::roundToInt(height * scaleFactor);
+
+    if (image.isValid() && image.getWidth() == physicalWidth && image.getHeight() == physicalHeight)
+        return false;
+
+    scale = scaleFactor;
+    image = physicalWidth > 0 && physicalHeight > 0
+        ? juce::Image(juce::Image::PixelFormat::ARGB, physicalWidth, physicalHeight, true, juce::SoftwareImageType())
+        : juce::Image();
+
+    dirtyRows.assign((size_t)juce::jmax(0, physicalWidth), { 0, 0 });
+    return true;
+}
+
+void TraceRasterizer::release()
+{
+    image = juce::Image();
+    dirtyRows = {};
+}
+
+void TraceRasterizer::beginFrame()
+{
+    if (!image.isValid())
+        return;
+
+    juce::Image::BitmapData pixels(image, juce::Image::BitmapData::readWrite);
+
+    for (int x = 0; x < pixels.width; ++x)
+    {
+        auto& [first, last] = dirtyRows[(size_t)x];
+        for (int y = first; y < last; ++y)
+            reinterpret_cast<juce::PixelARGB*>(pixels.getPixelPointer(x, y))->setARGB(0, 0, 0, 0);
+
+        first = last = 0;
+    }
+}
+
+void TraceRasterizer::drawPolyline(const juce::Path& path, juce::Colour colour, juce::Point<float> offset)
+{
+    if (!image.isValid())
+        return;
+
+    juce::Image::BitmapData pixels(image, juce::Image::BitmapData::readWrite);
+    auto pixel = colour.getPixelARGB(); //already premultiplied
+
+    juce::Point<float> last;
+    for (juce::Path::Iterator it(path); it.next();)
+    {
+        auto point = (juce::Point<float>(it.x1, it.y1) + offset) * scale;
+
+        if (it.elementType == juce::Path::Iterator::lineTo)
+            drawSegment(pixels, last, point, pixel);
+
+        last = point;
+    }
+}
+
+void TraceRasterizer::drawSegment(juce::Image::BitmapData& pixels,
+    juce::Point<float> from,
+    juce::Point<float> to,
+    juce::PixelARGB colour)
+{
+    if (to.x < from.x)
+        std::swap(from, to);
+
+    const auto halfWidth = 0.5f * scale;
+
+    //vertical segments, like a column's peak-to-dip, are a single span
+    if (to.x - from.x < 1e-3f)
+    {
+        fillSpan(pixels, (int)std::floor(from.x),
+            juce::jmin(from.y, to.y) - halfWidth, juce::jmax(from.y, to.y) + halfWidth, colour);
+        return;
+    }
+
+    auto slope = (to.y - from.y) / (to.x - from.x);
+    auto firstColumn = juce::jmax(0, (int)std::floor(from.x));
+    auto lastColumn = juce::jmin(pixels.width - 1, (int)std::floor(to.x));
+
+    for (int x = firstColumn; x <= lastColumn; ++x)
+    {
+        //where the segment enters and leaves this column
+        auto enter = juce::jmax(from.x, float(x));
+        auto leave = juce::jmin(to.x, float(x + 1));
+        auto yEnter = from.y + (enter - from.x) * slope;
+        auto yLeave = from.y + (leave - from.x) * slope;
+
+        fillSpan(pixels, x, juce::jmin(yEnter, yLeave) - halfWidth, juce::jmax(yEnter, yLeave) + halfWidth, colour);
+    }
+}
+
+void TraceRasterizer::fillSpan(juce::Image::BitmapData& pixels, int x, float top, float bottom, juce::PixelARGB colour)
+{
+    if (x < 0 || x >= pixels.width)
+        return;
+
+    top = juce::jmax(0.f, top);
+    bottom = juce::jmin(float(pixels.height), bottom);
+    if (bottom <= top)
+        return;
+
+    auto firstRow = (int)top;
+    auto lastRow = juce::jmin(pixels.height - 1, (int)bottom);
+
+    auto* dest = pixels.getPixelPointer(x, firstRow);
+    for (int y = firstRow; y <= lastRow; ++y, dest += pixels.lineStride)
+    {
+        //how much of this pixel's height the span covers
+        auto coverage = juce::jmin(bottom, float(y + 1)) - juce::jmax(top, float(y));
+        if (coverage > 0)
+            reinterpret_cast<juce::PixelARGB*>(dest)->blend(colour, (juce::uint32)juce::roundToInt(coverage * 255.f));
+    }
+
+    auto& [first, last] = dirtyRows[(size_t)x];
+    if (first == last)
+    {
+        first = firstRow;
+        last = lastRow + 1;
+    }
+    else
+    {
+        first = juce::jmin(first, firstRow);
+        last = juce::jmax(last, lastRow + 1);
+    }
+}
+
+void TraceRasterizer::draw(juce::Graphics& g, juce::Rectangle<float> area) const
+{
+    if (image.isValid())
+        g.drawImage(image, area);
+}
+
+std::shared_ptr<const std::vector<float>> FFTResourceCache::getWindow(int size, WindowingMethod method)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto& entry = windows[{ size, (int)method }];
+    if (auto table = entry.lock())
+        return table;
+
+    auto newTable = std::make_shared<std::vector<float>>((size_t)size);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(newTable->data(), (size_t)size, method, true);
+
+    std::shared_ptr<const std::vector<float>> table = std::move(newTable);
+    entry = table;
+    return table;
+}
+
 void RotarySliderWithLabels::paint(juce::Graphics& g)
 {
     using namespace juce;
@@ -183,134 +438,1201 @@ void RotarySliderWithLabels::paint(juce::Graphics& g)
         r.setCentre(c);
         r.setY(r.getY() + getTextHeight());
 
-        g.drawFittedText(str, r.toNearestInt(), juce::Justification::centred, 1);
-    } 
+        g.drawFittedText(str, r.toNearestInt(), juce::Justification::centred, 1);
+    } 
+}
+
+juce::String RotarySliderWithLabels::getDisplayString() const
+{
+    if (auto* choiceParam = dynamic_cast<juce::AudioParameterChoice*>(param))
+    {
+        return choiceParam->getCurrentChoiceName();
+    }
+    juce::String str;
+    bool addK = false;
+
+    if (auto* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param))
+    {
+        float value = getValue();
+
+        if (value >= 1000.f) 
+        {
+            value /= 1000.f;
+            addK = true;
+        }
+        str = juce::String(value, (addK ? 2 : 0));
+    }
+    else
+    {
+        jassertfalse;
+    }
+
+    if (suffix.isNotEmpty())
+    {
+        str << " ";
+        if (addK)
+        {
+            str << "K";
+        }
+        str << suffix;
+    }
+    return str;
+}
+
+juce::Rectangle<int> RotarySliderWithLabels::getSliderBounds() const
+{
+    auto bounds = getLocalBounds();
+
+    auto size = juce::jmin(bounds.getWidth(), bounds.getHeight());
+
+    size -= getTextHeight() * 2;
+    juce::Rectangle<int> r;
+    r.setSize(size, size);
+    r.setCentre(bounds.getCentreX(), 0);
+    r.setY(2);
+
+    return r;
+}
+
+
+ResponseCurveComponent::ResponseCurveComponent(SimpleEQAudioProcessor& p) : 
+    audioProcessor(p),
+    //leftChannelFifo(&audioProcessor.leftChannelFifo)
+    pathProducer(audioProcessor.leftChannelFifo, audioProcessor.rightChannelFifo),
+    prePathProducer(audioProcessor.preLeftChannelFifo, audioProcessor.preRightChannelFifo, 1)
+{
+    const auto& params = audioProcessor.getParameters();
+    for (auto param : params)
+    {
+        param->addListener(this);
+    }
+
+    //leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
+    //monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+
+    displayFFTAnalysis = audioProcessor.apvts.getRawParameterValue("Analyzer Enabled")->load() > 0.5f;
+    audioProcessor.setAnalyzerConsumer(this);
+
+    responseCurveSampleRate = audioProcessor.getSampleRate();
+    updateChain();
+
+    startTimerHz(timerRateHz);
+}
+
+ResponseCurveComponent::~ResponseCurveComponent()
+{
+    updateAnalyzerTap(false);
+    audioProcessor.setAnalyzerConsumer(nullptr);
+    cancelPendingUpdate();
+
+    const auto& params = audioProcessor.getParameters();
+    for (auto param : params)
+    {
+        param->removeListener(this);
+    }
+}
+
+void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
+{
+    parametersChanged.set(true);
+
+    //at the idle rate the next tick could be a quarter of a second away
+    if (timerIsIdle.load())
+        triggerAsyncUpdate();
+}
+
+void MultirateSpectrumGenerator::prepare(int newNumChannels)
+{
+    jassert(newNumChannels == 1 || newNumChannels == 2);
+    numChannels = newNumChannels;
+
+    channels.assign((size_t)numChannels, {});
+    for (auto& stages : channels)
+        for (auto& stage : stages)
+            stage.history.assign(stageSize, 0);
+
+    stageFFT = std::make_unique<juce::dsp::FFT>(stageOrder);
+    window = resourceCache->getWindow(stageSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
+
+    workspace.assign(stageSize * 2, 0);
+    stageDecibels.assign(numStages * stageSize / 2, 0);
+    pointSources.assign(numPoints, {});
+    pointSourcesSampleRate = 0;
+
+    spectrumFifo.prepare(size_t(numPoints * numChannels));
+}
+
+void MultirateSpectrumGenerator::release()
+{
+    channels = {};
+    workspace = {};
+    stageDecibels = {};
+    pointSources = {};
+    pointSourcesSampleRate = 0;
+    stageFFT.reset();
+    window.reset();
+    spectrumFifo.release();
+}
+
+void MultirateSpectrumGenerator::reset()
+{
+    for (auto& stages : channels)
+    {
+        for (auto& stage : stages)
+        {
+            std::fill(stage.history.begin(), stage.history.end(), 0.f);
+            stage.writePos = 0;
+            stage.decimator = {};
+        }
+    }
+}
+
+void MultirateSpectrumGenerator::pushSample(std::array<Stage, numStages>& stages, float x)
+{
+    for (int k = 0; k < numStages; ++k)
+    {
+        auto& stage = stages[k];
+        stage.history[stage.writePos] = x;
+        stage.writePos = (stage.writePos + 1) & (stageSize - 1);
+
+        //every other sample carries on to the next octave down
+        if (k == numStages - 1 || !stage.decimator.push(x, x))
+            break;
+    }
+}
+
+void MultirateSpectrumGenerator::pushSamples(const float* a, const float* b, int numSamples, bool midSide)
+{
+    if (numChannels == 1)
+    {
+        //a mono generator analyses the sum when it is given two channels
+        for (int i = 0; i < numSamples; ++i)
+            pushSample(channels[0], b != nullptr ? 0.5f * (a[i] + b[i]) : a[i]);
+        return;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto first = a[i], second = b[i];
+        if (midSide)
+        {
+            auto mid = 0.5f * (first + second);
+            second = mid - second;
+            first = mid;
+        }
+
+        pushSample(channels[0], first);
+        pushSample(channels[1], second);
+    }
+}
+
+void MultirateSpectrumGenerator::updatePointSources(double sampleRate)
+{
+    //the 11-tap halfband starts to alias above ~0.2 of its output rate, so an
+    //octave is only trusted up to 0.4 of its nyquist. each point reads from the
+    //most decimated stage that still covers it, i.e. the finest bin spacing.
+    constexpr double usableFraction = 0.2;
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        auto freq = juce::mapToLog10(double(i) / double(numPoints - 1), 20.0, 20000.0);
+
+        int stage = 0;
+        for (int k = numStages - 1; k > 0; --k)
+        {
+            if (freq <= usableFraction * sampleRate / double(1 << k))
+            {
+                stage = k;
+                break;
+            }
+        }
+
+        auto binWidth = sampleRate / double(1 << stage) / double(stageSize);
+        auto bin = juce::jlimit(0.0, double(stageSize / 2 - 1) - 1e-3, freq / binWidth);
+
+        pointSources[i] = { stage, int(bin), float(bin - std::floor(bin)) };
+    }
+
+    pointSourcesSampleRate = sampleRate;
+}
+
+void MultirateSpectrumGenerator::produceSpectrumForRendering(double sampleRate, float negativeInfinity)
+{
+    if (sampleRate <= 0)
+        return;
+
+    auto* slot = spectrumFifo.acquireWrite();
+    if (slot == nullptr)
+        return;
+
+    if (sampleRate != pointSourcesSampleRate)
+        updatePointSources(sampleRate);
+
+    constexpr int numBins = stageSize / 2;
+    const auto* windowTable = window->data();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        for (int k = 0; k < numStages; ++k)
+        {
+            //unroll the ring oldest first while windowing
+            auto& stage = channels[(size_t)channel][k];
+            auto olderSpan = stageSize - stage.writePos;
+            juce::FloatVectorOperations::multiply(workspace.data(), stage.history.data() + stage.writePos, windowTable, olderSpan);
+            juce::FloatVectorOperations::multiply(workspace.data() + olderSpan, stage.history.data(), windowTable + olderSpan, stage.writePos);
+
+            stageFFT->performRealOnlyForwardTransform(workspace.data(), true);
+            convertBinsToDecibels(workspace.data(), stageDecibels.data() + k * numBins, numBins, negativeInfinity);
+        }
+
+        auto* out = slot->data() + channel * numPoints;
+        for (int i = 0; i < numPoints; ++i)
+        {
+            const auto& source = pointSources[i];
+            const auto* bins = stageDecibels.data() + source.stage * numBins + source.bin;
+            out[i] = bins[0] + source.frac * (bins[1] - bins[0]);
+        }
+    }
+
+    spectrumFifo.commitWrite();
+}
+
+size_t MultirateSpectrumGenerator::getMemoryUsage() const
+{
+    return spectrumFifo.getMemoryUsage()
+        + (channels.size() * numStages * stageSize + workspace.capacity() + stageDecibels.capacity()) * sizeof(float)
+        + pointSources.capacity() * sizeof(PointSource);
+}
+
+void SpectrumSmoother::prepare(int maxBins)
+{
+    prefixSum.assign(size_t(maxBins + 1), 0);
+    rangesNumBins = 0;
+}
+
+void SpectrumSmoother::release()
+{
+    prefixSum = {};
+    columns = {};
+    ranges = {};
+    rangesNumBins = 0;
+}
+
+void SpectrumSmoother::updateRanges(int numBins, double binWidth, int fraction, int numColumns)
+{
+    //storage only grows here when the display gets wider
+    columns.resize((size_t)numColumns);
+    ranges.resize((size_t)numColumns);
+
+    const auto halfBand = std::exp2(0.5 / double(fraction));
+
+    for (int i = 0; i < numColumns; ++i)
+    {
+        auto centre = juce::mapToLog10(double(i) / double(numColumns - 1), 20.0, 20000.0);
+        auto lo = int(std::ceil(centre / halfBand / binWidth));
+        auto hi = int(std::floor(centre * halfBand / binWidth));
+
+        auto& range = ranges[(size_t)i];
+        if (hi > lo)
+        {
+            range = { juce::jlimit(1, numBins - 1, lo), juce::jlimit(1, numBins - 1, hi), 0.f, false };
+        }
+        else
+        {
+            auto bin = juce::jlimit(1.0, double(numBins - 1) - 1e-3, centre / binWidth);
+            range = { int(bin), int(bin), float(bin - std::floor(bin)), true };
+        }
+    }
+
+    rangesNumBins = numBins;
+    rangesBinWidth = binWidth;
+    rangesFraction = fraction;
+}
+
+const float* SpectrumSmoother::process(const float* decibels,
+    int numBins,
+    double binWidth,
+    int fraction,
+    int numColumns,
+    float negativeInfinity)
+{
+    jassert(fraction > 0 && numColumns > 1);
+    jassert(size_t(numBins + 1) <= prefixSum.size());
+
+    if (numBins != rangesNumBins || binWidth != rangesBinWidth || fraction != rangesFraction
+        || numColumns != (int)ranges.size())
+        updateRanges(numBins, binWidth, fraction, numColumns);
+
+    //back to power for averaging. doubles keep the quiet top octaves from
+    //vanishing in the rounding error of the loud bass bins below them.
+    constexpr float octavesPerDecibel = 1.f / 3.0103f;
+    auto* sums = prefixSum.data();
+    sums[0] = 0;
+    for (int i = 0; i < numBins; ++i)
+        sums[i + 1] = sums[i] + fastExp2(decibels[i] * octavesPerDecibel);
+
+    for (int i = 0; i < numColumns; ++i)
+    {
+        const auto& range = ranges[(size_t)i];
+        if (range.interpolate)
+        {
+            auto a = decibels[range.lo];
+            columns[(size_t)i] = a + range.frac * (decibels[range.lo + 1] - a);
+            continue;
+        }
+
+        auto mean = float((sums[range.hi + 1] - sums[range.lo]) / double(range.hi - range.lo + 1));
+        columns[(size_t)i] = juce::jmax(negativeInfinity, 3.0103f * fastLog2(mean));
+    }
+
+    return columns.data();
+}
+
+size_t SpectrumSmoother::getMemoryUsage() const
+{
+    return prefixSum.capacity() * sizeof(double)
+        + columns.capacity() * sizeof(float)
+        + ranges.capacity() * sizeof(ColumnRange);
+}
+
+void SpectrogramColumnBuilder::updateRowRanges(int numValues, double binWidth)
+{
+    for (int row = 0; row < numRows; ++row)
+    {
+        auto lowerEdge = double(row) / double(numRows);
+        auto upperEdge = double(row + 1) / double(numRows);
+
+        double lo, hi;
+        if (binWidth > 0)
+        {
+            lo = juce::mapToLog10(lowerEdge, 20.0, 20000.0) / binWidth;
+            hi = juce::mapToLog10(upperEdge, 20.0, 20000.0) / binWidth;
+        }
+        else
+        {
+            lo = lowerEdge * double(numValues - 1);
+            hi = upperEdge * double(numValues - 1);
+        }
+
+        auto first = juce::jlimit(0, numValues - 1, int(lo));
+        auto last = juce::jlimit(first, numValues - 1, int(hi));
+        rowRanges[row] = { first, last };
+    }
+
+    rangesNumValues = numValues;
+    rangesBinWidth = binWidth;
+}
+
+void SpectrogramColumnBuilder::pushColumn(const float* spectra,
+    int numValues,
+    int numChannels,
+    double binWidth,
+    float negativeInfinity)
+{
+    auto* column = columnFifo.acquireWrite();
+    if (column == nullptr)
+        return;
+
+    if (numValues != rangesNumValues || binWidth != rangesBinWidth)
+        updateRowRanges(numValues, binWidth);
+
+    const auto scale = 255.f / -negativeInfinity;
+
+    for (int row = 0; row < numRows; ++row)
+    {
+        auto [first, last] = rowRanges[row];
+        auto peak = negativeInfinity;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* values = spectra + channel * numValues;
+            for (int i = first; i <= last; ++i)
+                peak = juce::jmax(peak, values[i]);
+        }
+
+        (*column)[row] = juce::uint8(juce::jlimit(0.f, 255.f, (peak - negativeInfinity) * scale + 0.5f));
+    }
+
+    columnFifo.commitWrite();
+}
+
+void SpectrogramView::allocate()
+{
+    if (isAllocated())
+        return;
+
+    history.assign(size_t(historyLength) * SpectrogramColumnBuilder::numRows, 0);
+    historyWritePos = 0;
+    numColumnsStored = 0;
+    scrollback = 0;
+
+    //same background as the response area at silence, through olive to yellow at 0 dB
+    juce::ColourGradient gradient(juce::Colour(40u, 40u, 53u), 0.f, 0.f, juce::Colours::yellow, 1.f, 0.f, false);
+    gradient.addColour(0.4, juce::Colours::darkslateblue);
+    gradient.addColour(0.7, juce::Colours::olive);
+
+    for (size_t i = 0; i < palette.size(); ++i)
+        palette[i] = gradient.getColourAtPosition(double(i) / double(palette.size() - 1));
+}
+
+void SpectrogramView::release()
+{
+    history = {};
+    historyWritePos = 0;
+    numColumnsStored = 0;
+    scrollback = 0;
+    image = juce::Image();
+}
+
+void SpectrogramView::clear()
+{
+    std::fill(history.begin(), history.end(), juce::uint8(0));
+    historyWritePos = 0;
+    numColumnsStored = 0;
+    scrollback = 0;
+
+    if (image.isValid())
+        image.clear(image.getBounds(), palette[0]);
+}
+
+void SpectrogramView::setSize(int width, int height)
+{
+    if (!isAllocated() || width <= 0 || height <= 0)
+        return;
+
+    if (image.isValid() && image.getWidth() == width && image.getHeight() == height)
+        return;
+
+    //software pixels, so BitmapData writes in place instead of mapping a native image every column
+    image = juce::Image(juce::Image::PixelFormat::RGB, width, height, false, juce::SoftwareImageType());
+    scrollback = juce::jmin(scrollback, getMaxScrollback());
+    renderVisibleHistory();
+}
+
+void SpectrogramView::pushColumn(const Column& column)
+{
+    if (!isAllocated())
+        return;
+
+    auto* stored = history.data() + size_t(historyWritePos) * SpectrogramColumnBuilder::numRows;
+    std::copy(column.begin(), column.end(), stored);
+    historyWritePos = (historyWritePos + 1) % historyLength;
+    numColumnsStored = juce::jmin(numColumnsStored + 1, historyLength);
+
+    //scrolled back, the view stays on the same columns until they drop out of the ring
+    auto previousScrollback = scrollback;
+    if (scrollback > 0)
+        scrollback = juce::jmin(scrollback + 1, getMaxScrollback());
+
+    if (scrollback > previousScrollback || !image.isValid())
+        return;
+
+    scrollInColumn(getStoredColumn(scrollback));
+}
+
+void SpectrogramView::setScrollback(int columnsBack)
+{
+    columnsBack = juce::jlimit(0, getMaxScrollback(), columnsBack);
+    if (columnsBack == scrollback)
+        return;
+
+    scrollback = columnsBack;
+
+    if (image.isValid())
+        renderVisibleHistory();
+}
+
+int SpectrogramView::getMaxScrollback() const
+{
+    //far enough back that the oldest column stored reaches the left edge
+    auto width = image.isValid() ? image.getWidth() : 1;
+    return juce::jmax(0, numColumnsStored - width);
+}
+
+const juce::uint8* SpectrogramView::getStoredColumn(int columnsBack) const
+{
+    auto index = (historyWritePos - 1 - columnsBack + 2 * historyLength) % historyLength;
+    return history.data() + size_t(index) * SpectrogramColumnBuilder::numRows;
+}
+
+void SpectrogramView::renderColumn(const juce::uint8* column, int x)
+{
+    auto height = image.getHeight();
+    juce::Image::BitmapData pixels(image, x, 0, 1, height, juce::Image::BitmapData::writeOnly);
+
+    //row 0 is the lowest frequency, so it goes at the bottom
+    for (int y = 0; y < height; ++y)
+    {
+        auto row = (height - 1 - y) * SpectrogramColumnBuilder::numRows / height;
+        pixels.setPixelColour(0, y, palette[column[row]]);
+    }
+}
+
+void SpectrogramView::scrollInColumn(const juce::uint8* column)
+{
+    //a memmove per row on software pixels, far cheaper than re-rendering what's already on screen
+    auto width = image.getWidth();
+    image.moveImageSection(0, 0, 1, 0, width - 1, image.getHeight());
+    renderColumn(column, width - 1);
+}
+
+void SpectrogramView::renderVisibleHistory()
+{
+    auto width = image.getWidth();
+    image.clear(image.getBounds(), palette[0]);
+
+    //the column scrollback before the newest goes at the right edge, older ones leftwards from it
+    auto numVisible = juce::jmin(width, numColumnsStored - scrollback);
+    for (int i = 0; i < numVisible; ++i)
+        renderColumn(getStoredColumn(scrollback + i), width - 1 - i);
+}
+
+void SpectrogramView::draw(juce::Graphics& g, juce::Rectangle<int> area) const
+{
+    if (image.isValid())
+        g.drawImageAt(image, area.getX(), area.getY());
+}
+
+size_t SpectrogramView::getMemoryUsage() const
+{
+    auto bytes = history.capacity();
+    if (image.isValid())
+        bytes += size_t(image.getWidth()) * size_t(image.getHeight()) * 3;
+
+    return bytes;
+}
+
+void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
+{
+    auto wantedEngine = requestedEngine.load();
+    if (wantedEngine != engine)
+    {
+        //the octave rings only fill while their engine is running, so start them clean
+        engine = wantedEngine;
+        multirateGenerator.reset();
+        samplesSinceLastFFT = 0;
+    }
+
+    auto wantedOrder = requestedOrder.load();
+    if (wantedOrder != fftDataGenerator.getOrder())
+    {
+        //allocate() prepared every order, so this only points at another plan and window
+        fftDataGenerator.changeOrder(wantedOrder, numChannels);
+
+        //the history is already full, so draw the new resolution straight away
+        samplesSinceLastFFT = history.getNumSamples();
+    }
+
+    drainFifos();
+
+    //once the whole history is silent, one more frame draws the floor and
+    //then nothing changes, so stop analysing until sound comes back
+    auto silent = silentRunLength >= history.getNumSamples();
+    inputSilent.store(silent);
+    auto hopElapsed = samplesSinceLastFFT >= getHopSize();
+    if (hopElapsed)
+    {
+        samplesSinceLastFFT = 0;
+
+        if (silent && publishedSilentFrame)
+            hopElapsed = false;
+
+        publishedSilentFrame = silent;
+    }
+
+    //only the newest spectrum is ever drawn, so run at most one fft per frame,
+    //and only once a full hop of new audio has arrived. this keeps the cost
+    //independent of the host block size.
+    if (engine == AnalyzerEngine::ConstantQ)
+    {
+        if (hopElapsed)
+            multirateGenerator.produceSpectrumForRendering(sampleRate, -48.f);
+
+        while (auto* spectrum = multirateGenerator.acquireSpectrum())
+        {
+            if (view.load() == AnalyzerView::Spectrogram)
+            {
+                spectrogramBuilder.pushColumn(spectrum->data(), MultirateSpectrumGenerator::numPoints, numChannels, 0, -48.f);
+                multirateGenerator.releaseSpectrum();
+                continue;
+            }
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                pathGenerators[channel].generateLogSpacedPath(spectrum->data() + channel * MultirateSpectrumGenerator::numPoints,
+                    MultirateSpectrumGenerator::numPoints, fftBounds, -48.f);
+            }
+
+            multirateGenerator.releaseSpectrum();
+        }
+
+        return;
+    }
+
+    if (hopElapsed)
+    {
+        copyHistoryToFrameBuffer();
+        fftDataGenerator.produceFFTDataForRendering(frameBuffer, -48.f);
+    }
+
+    const auto fftSize = fftDataGenerator.getFFTSize();
+    const auto numBins = fftSize / 2;
+    const auto binWidth = sampleRate / (double)fftSize;
+    const auto fraction = (int)smoothing.load();
+    const auto numColumns = juce::jmax(2, (int)fftBounds.getWidth() + 1);
+    while (auto* fftData = fftDataGenerator.acquireFFTData())
+    {
+        if (view.load() == AnalyzerView::Spectrogram)
+        {
+            spectrogramBuilder.pushColumn(fftData->data(), numBins, numChannels, binWidth, -48.f);
+            fftDataGenerator.releaseFFTData();
+            continue;
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* decibels = fftData->data() + channel * numBins;
+
+            if (fraction == AnalyzerSmoothing::NoSmoothing)
+            {
+                pathGenerators[channel].generatePath(decibels, fftBounds, fftSize, binWidth, -48.f);
+                continue;
+            }
+
+            auto* smoothed = smoother.process(decibels, numBins, binWidth, fraction, numColumns, -48.f);
+            pathGenerators[channel].generateLogSpacedPath(smoothed, numColumns, fftBounds, -48.f);
+        }
+
+        fftDataGenerator.releaseFFTData();
+    }
+}
+
+void PathProducer::drainFifos()
+{
+    //the audio thread feeds both fifos in the same block, so drain them in pairs;
+    //a buffer whose partner hasn't arrived yet waits for the next frame
+    for (;;)
+    {
+        auto* first = channelFifos[0]->acquireAudioBuffer();
+        auto* second = channelFifos[1]->acquireAudioBuffer();
+        if (first == nullptr || second == nullptr)
+            break;
+
+        pushIntoHistory(*first, *second);
+
+        channelFifos[0]->releaseAudioBuffer();
+        channelFifos[1]->releaseAudioBuffer();
+    }
+}
+
+bool PathProducer::pullLatestPaths()
+{
+    bool gotPath = false;
+    for (int channel = 0; channel < numChannels; ++channel)
+        gotPath |= pathGenerators[channel].swapLatestPath(channelFFTPaths[channel]);
+
+    return gotPath;
+}
+
+void PathProducer::pushIntoHistory(const SimpleEQAudioProcessor::BlockType& first,
+    const SimpleEQAudioProcessor::BlockType& second)
+{
+    jassert(first.getNumSamples() == second.getNumSamples());
+
+    auto historySize = history.getNumSamples();
+    auto numSamples = first.getNumSamples();
+    auto offset = 0;
+
+    //fifo blocks follow the host block size, which may exceed the fft size
+    if (numSamples > historySize)
+    {
+        offset = numSamples - historySize;
+        numSamples = historySize;
+    }
+
+    auto firstSpan = juce::jmin(numSamples, historySize - historyWritePos);
+    if (numChannels == 1)
+    {
+        auto* a = first.getReadPointer(0, offset);
+        auto* b = second.getReadPointer(0, offset);
+
+        auto sumInto = [a, b](float* dest, int start, int num)
+        {
+            juce::FloatVectorOperations::add(dest, a + start, b + start, num);
+            juce::FloatVectorOperations::multiply(dest, 0.5f, num);
+        };
+
+        sumInto(history.getWritePointer(0, historyWritePos), 0, firstSpan);
+
+        if (firstSpan < numSamples)
+            sumInto(history.getWritePointer(0, 0), firstSpan, numSamples - firstSpan);
+    }
+    else
+    {
+        const SimpleEQAudioProcessor::BlockType* sources[] { &first, &second };
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* samples = sources[channel]->getReadPointer(0, offset);
+            juce::FloatVectorOperations::copy(history.getWritePointer(channel, historyWritePos), samples, firstSpan);
+
+            if (firstSpan < numSamples)
+                juce::FloatVectorOperations::copy(history.getWritePointer(channel, 0), samples + firstSpan, numSamples - firstSpan);
+        }
+    }
+
+    historyWritePos = (historyWritePos + numSamples) % historySize;
+    samplesSinceLastFFT = juce::jmin(samplesSinceLastFFT + numSamples, historySize);
+
+    auto peak = 0.f;
+    for (const auto* source : { &first, &second })
+        peak = juce::jmax(peak, source->getMagnitude(0, offset, numSamples));
+
+    silentRunLength = peak < silenceThreshold ? juce::jmin(silentRunLength + numSamples, historySize) : 0;
+
+    if (engine == AnalyzerEngine::ConstantQ)
+    {
+        multirateGenerator.pushSamples(first.getReadPointer(0, offset), second.getReadPointer(0, offset), numSamples,
+            channelMode.load() == AnalyzerChannelMode::MidSide);
+    }
+}
+
+void PathProducer::copyHistoryToFrameBuffer()
+{
+    //unroll the newest fftSize samples of the ring so the oldest comes first
+    auto historySize = history.getNumSamples();
+    auto fftSize = fftDataGenerator.getFFTSize();
+    auto start = (historyWritePos - fftSize + historySize) % historySize;
+    auto olderSpan = juce::jmin(fftSize, historySize - start);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        juce::FloatVectorOperations::copy(frameBuffer.getWritePointer(channel, 0),
+            history.getReadPointer(channel, start),
+            olderSpan);
+
+        if (olderSpan < fftSize)
+        {
+            juce::FloatVectorOperations::copy(frameBuffer.getWritePointer(channel, olderSpan),
+                history.getReadPointer(channel, 0),
+                fftSize - olderSpan);
+        }
+    }
+
+    if (numChannels == 2 && channelMode.load() == AnalyzerChannelMode::MidSide)
+        convertToMidSide(frameBuffer.getWritePointer(0), frameBuffer.getWritePointer(1), fftSize);
+}
+
+int PathProducer::getHopSize() const
+{
+    auto fftSize = fftDataGenerator.getFFTSize();
+    return juce::jmax(1, juce::roundToInt(fftSize * (1.f - overlap.load())));
+}
+
+void PathProducer::resync()
+{
+    for (auto* fifo : channelFifos)
+        fifo->discardPending();
+
+    history.clear();
+    historyWritePos = 0;
+    samplesSinceLastFFT = 0;
+    silentRunLength = 0;
+    publishedSilentFrame = false;
+    inputSilent.store(false);
+    multirateGenerator.reset();
+}
+
+void PathProducer::clearDisplayedAnalysis()
+{
+    //only the reading ends of the fifos are touched, so a frame may be in flight
+    pullLatestPaths();
+
+    for (auto& path : channelFFTPaths)
+        path.clear();
+
+    while (spectrogramBuilder.acquireColumn() != nullptr)
+        spectrogramBuilder.releaseColumn();
+}
+
+void PathProducer::allocate()
+{
+    if (isAllocated())
+        return;
+
+    //visit every order once, largest first, so the storage is sized for maxOrder and each
+    //order's plan and window already exist; later switches then never allocate
+    for (auto order : { maxOrder, FFTOrder::order4096, FFTOrder::order2048 })
+        fftDataGenerator.changeOrder(order, numChannels);
+
+    auto maxFFTSize = 1 << maxOrder;
+    fftDataGenerator.changeOrder(requestedOrder.load(), numChannels);
+    multirateGenerator.prepare(numChannels);
+    smoother.prepare(maxFFTSize / 2);
+
+    frameBuffer.setSize(numChannels, maxFFTSize);
+    frameBuffer.clear();
+    history.setSize(numChannels, maxFFTSize);
+    history.clear();
+    historyWritePos = 0;
+    samplesSinceLastFFT = 0;
+}
+
+void PathProducer::release()
+{
+    fftDataGenerator.release();
+    multirateGenerator.release();
+    smoother.release();
+    frameBuffer = juce::AudioBuffer<float>();
+    history = juce::AudioBuffer<float>();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        pathGenerators[channel].release();
+        channelFFTPaths[channel] = juce::Path();
+    }
+}
+
+size_t PathProducer::getMemoryUsage() const
+{
+    return fftDataGenerator.getMemoryUsage()
+        + multirateGenerator.getMemoryUsage()
+        + smoother.getMemoryUsage()
+        + size_t(numChannels) * size_t(frameBuffer.getNumSamples() + history.getNumSamples()) * sizeof(float);
+}
+
+void ResponseCurveComponent::updateAnalyzerTap(bool consumerAttached)
+{
+    //keeps prepareToPlay from resizing the fifos halfway through
+    const juce::ScopedLock sl(audioProcessor.getAnalyzerStorageLock());
+
+    auto shouldBeActive = consumerAttached && displayFFTAnalysis && hasPainted;
+
+    if (shouldBeActive == isRegisteredForAnalysis)
+        return;
+
+    isRegisteredForAnalysis = shouldBeActive;
+
+    if (shouldBeActive)
+    {
+        //the scheduler doesn't know about us yet, so the producers are ours to touch
+        pathProducer.allocate();
+        pathProducer.resync();
+        pathProducer.clearDisplayedAnalysis();
+
+        audioProcessor.setAnalyzerTapActive(true);
+        analysisScheduler->addClient(this);
+    }
+    else
+    {
+        //stop consuming before the processor frees the fifos we read from
+        analysisScheduler->removeClient(this);
+        audioProcessor.setAnalyzerTapActive(false);
+
+        pathProducer.release();
+        traceRasterizer.release();
+    }
+
+    updatePreAnalyzerTap();
+}
+
+void ResponseCurveComponent::updatePreAnalyzerTap()
+{
+    const juce::ScopedLock sl(audioProcessor.getAnalyzerStorageLock());
+
+    auto shouldBeActive = isRegisteredForAnalysis && showPreEQOverlay && analyzerView == AnalyzerView::Lines;
+
+    if (shouldBeActive == isPreTapActive)
+        return;
+
+    //the analysis thread reads isPreTapActive, so step out of the frame while it changes
+    if (isRegisteredForAnalysis)
+        analysisScheduler->removeClient(this);
+
+    isPreTapActive = shouldBeActive;
+
+    if (shouldBeActive)
+    {
+        prePathProducer.allocate();
+        prePathProducer.resync();
+        prePathProducer.clearDisplayedAnalysis();
+        audioProcessor.setPreAnalyzerTapActive(true);
+    }
+    else
+    {
+        audioProcessor.setPreAnalyzerTapActive(false);
+        prePathProducer.release();
+    }
+
+    if (isRegisteredForAnalysis)
+        analysisScheduler->addClient(this);
+}
+
+void ResponseCurveComponent::suspendAnalyzerReads()
+{
+    //returns once any frame in flight has finished with the fifos
+    if (isRegisteredForAnalysis)
+        analysisScheduler->removeClient(this);
+}
+
+void ResponseCurveComponent::resumeAnalyzerReads()
+{
+    if (!isRegisteredForAnalysis)
+        return;
+
+    //the message thread may be painting the paths or draining the spectrogram
+    //right now, so it does the restart itself
+    analyzerRestartPending.store(true);
+    triggerAsyncUpdate();
+}
+
+void ResponseCurveComponent::restartAnalysis()
+{
+    const juce::ScopedLock sl(audioProcessor.getAnalyzerStorageLock());
+
+    if (!isRegisteredForAnalysis)
+        return;
+
+    //updatePreAnalyzerTap() may have re-registered us since the suspend
+    analysisScheduler->removeClient(this);
+
+    pathProducer.resync();
+    pathProducer.clearDisplayedAnalysis();
+
+    if (isPreTapActive)
+    {
+        prePathProducer.resync();
+        prePathProducer.clearDisplayedAnalysis();
+    }
+
+    analyzerLayerDirty = true;
+    analysisScheduler->addClient(this);
+}
+
+void ResponseCurveComponent::handleAsyncUpdate()
+{
+    if (analyzerRestartPending.exchange(false))
+        restartAnalysis();
+
+    //a parameter moved while idle: go back to the adaptive rate and draw the change now
+    if (timerIsIdle.load() && parametersChanged.get() && isShowing())
+    {
+        lastActivityTime = juce::Time::getMillisecondCounterHiRes() * 0.001;
+        setTimerRate(frameRate.getRateHz());
+        timerCallback();
+    }
+}
+
+void ResponseCurveComponent::setPreEQOverlayVisible(bool shouldBeVisible)
+{
+    showPreEQOverlay = shouldBeVisible;
+    updatePreAnalyzerTap();
+
+    analyzerLayerDirty = true;
+    repaint(getRenderArea());
+}
+
+void ResponseCurveComponent::setAnalyzerOverlap(float overlap)
+{
+    pathProducer.setOverlap(overlap);
+    prePathProducer.setOverlap(overlap);
+}
+
+void ResponseCurveComponent::setAnalyzerOrder(FFTOrder order)
+{
+    pathProducer.setOrder(order);
+    prePathProducer.setOrder(order);
+}
+
+void ResponseCurveComponent::setAnalyzerEngine(AnalyzerEngine engine)
+{
+    pathProducer.setEngine(engine);
+    prePathProducer.setEngine(engine);
+}
+
+void ResponseCurveComponent::setAnalyzerSmoothing(AnalyzerSmoothing smoothing)
+{
+    pathProducer.setSmoothing(smoothing);
+    prePathProducer.setSmoothing(smoothing);
+}
+
+AnalysisScheduler::AnalysisScheduler() :
+    juce::Thread("SimpleEQ Analysis Clock"),
+    pool(juce::jmax(1, juce::SystemStats::getNumCpus() - 1))
+{
+    for (int i = 0; i < pool.getNumThreads(); ++i)
+        helpers.add(new HelperJob(*this));
+
+    startThread();
+}
+
+AnalysisScheduler::~AnalysisScheduler()
+{
+    stopThread(2000);
+    pool.removeAllJobs(true, 2000);
 }
 
-juce::String RotarySliderWithLabels::getDisplayString() const
+void AnalysisScheduler::addClient(Client* client)
 {
-    if (auto* choiceParam = dynamic_cast<juce::AudioParameterChoice*>(param))
     {
-        return choiceParam->getCurrentChoiceName();
+        const juce::ScopedLock sl(clientLock);
+        clients.addIfNotAlreadyThere(client);
     }
-    juce::String str;
-    bool addK = false;
 
-    if (auto* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param))
-    {
-        float value = getValue();
+    notify();
+}
 
-        if (value >= 1000.f) 
+void AnalysisScheduler::removeClient(Client* client)
+{
+    const juce::ScopedLock sl(clientLock);
+    clients.removeFirstMatchingValue(client);
+}
+
+void AnalysisScheduler::run()
+{
+    const auto framePeriodMs = 1000.0 / frameRateHz;
+    auto nextFrameTime = juce::Time::getMillisecondCounterHiRes();
+
+    while (!threadShouldExit())
+    {
+        bool idle;
         {
-            value /= 1000.f;
-            addK = true;
+            const juce::ScopedLock sl(clientLock);
+            idle = clients.isEmpty();
         }
-        str = juce::String(value, (addK ? 2 : 0));
-    }
-    else
-    {
-        jassertfalse;
-    }
 
-    if (suffix.isNotEmpty())
-    {
-        str << " ";
-        if (addK)
+        if (idle)
         {
-            str << "K";
+            //nothing to analyse: sleep until addClient() wakes us
+            wait(-1);
+            nextFrameTime = juce::Time::getMillisecondCounterHiRes();
+            continue;
         }
-        str << suffix;
+
+        runFrame();
+
+        //pace frames against an absolute clock; after an overrun, start again from now
+        nextFrameTime += framePeriodMs;
+        auto now = juce::Time::getMillisecondCounterHiRes();
+        if (nextFrameTime < now)
+            nextFrameTime = now;
+
+        wait((int)(nextFrameTime - now));
     }
-    return str;
 }
 
-juce::Rectangle<int> RotarySliderWithLabels::getSliderBounds() const
+void AnalysisScheduler::runFrame()
 {
-    auto bounds = getLocalBounds();
+    const juce::ScopedLock sl(clientLock);
 
-    auto size = juce::jmin(bounds.getWidth(), bounds.getHeight());
+    nextClient.store(0);
 
-    size -= getTextHeight() * 2;
-    juce::Rectangle<int> r;
-    r.setSize(size, size);
-    r.setCentre(bounds.getCentreX(), 0);
-    r.setY(2);
+    //this thread takes a share of the batch too, so one client needs no helpers
+    auto numHelpers = juce::jmin(clients.size() - 1, helpers.size());
+    for (int i = 0; i < numHelpers; ++i)
+        pool.addJob(helpers.getUnchecked(i), false);
 
-    return r;
+    processClients();
+
+    for (int i = 0; i < numHelpers; ++i)
+        pool.waitForJobToFinish(helpers.getUnchecked(i), -1);
 }
 
+void AnalysisScheduler::processClients()
+{
+    for (;;)
+    {
+        auto index = nextClient.fetch_add(1);
+        if (index >= clients.size())
+            break;
+
+        clients.getUnchecked(index)->runAnalysisFrame();
+    }
+}
 
-ResponseCurveComponent::ResponseCurveComponent(SimpleEQAudioProcessor& p) : 
-    audioProcessor(p),
-    //leftChannelFifo(&audioProcessor.leftChannelFifo)
-    leftPathProducer(audioProcessor.leftChannelFifo),
-    rightPathProducer(audioProcessor.rightChannelFifo)
+void ResponseCurveComponent::runAnalysisFrame()
 {
-    const auto& params = audioProcessor.getParameters();
-    for (auto param : params)
+    juce::Rectangle<float> fftBounds;
+    double sampleRate;
     {
-        param->addListener(this);
+        const juce::SpinLock::ScopedLockType sl(analysisSettingsLock);
+        fftBounds = analysisBounds;
+        sampleRate = analysisSampleRate;
     }
 
-    //leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
-    //monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+    if (fftBounds.isEmpty() || sampleRate <= 0)
+        return;
 
-    updateChain();
+    auto start = juce::Time::getHighResolutionTicks();
 
-    startTimerHz(60);
-}
+    if (analysisPaused.load())
+    {
+        //keep the fifos moving so the history is current when we come back
+        pathProducer.drainFifos();
 
-ResponseCurveComponent::~ResponseCurveComponent()
-{
-    const auto& params = audioProcessor.getParameters();
-    for (auto param : params)
+        if (isPreTapActive)
+            prePathProducer.drainFifos();
+    }
+    else if (++analysisFrameCounter >= analysisFrameInterval.load())
     {
-        param->removeListener(this);
+        analysisFrameCounter = 0;
+
+        pathProducer.process(fftBounds, sampleRate);
+
+        if (isPreTapActive)
+            prePathProducer.process(fftBounds, sampleRate);
     }
-}
 
-void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
-{
-    parametersChanged.set(true);
+    analysisTicksSinceLastTick.fetch_add(juce::Time::getHighResolutionTicks() - start);
 }
 
-void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
+void ResponseCurveComponent::setAnalyzerView(AnalyzerView view)
 {
-    juce::AudioBuffer<float> tempIncomingBuffer;
+    analyzerView = view;
 
-    while (leftChannelFifo->getNumCompleteBuffersAvailable())
+    //the history only exists while it's on screen
+    if (view == AnalyzerView::Spectrogram && displayFFTAnalysis)
     {
-        if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer))
-        {
-            auto size = tempIncomingBuffer.getNumSamples();
-            juce::FloatVectorOperations::copy(
-                monoBuffer.getWritePointer(0, 0),
-                monoBuffer.getReadPointer(0, size),
-                monoBuffer.getNumSamples() - size);
-
-            juce::FloatVectorOperations::copy(
-                monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-                tempIncomingBuffer.getReadPointer(0, 0),
-                size);
-
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
-
-        }
+        spectrogramView.allocate();
+        auto area = getAnalysisArea();
+        spectrogramView.setSize(area.getWidth(), area.getHeight());
     }
-    const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
-    const auto binWidth = sampleRate / (double)fftSize;
-    while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks())
+    else
     {
-        std::vector<float> fftData;
-        if (leftChannelFFTDataGenerator.getFFTData(fftData))
-        {
-            pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, -48.f);
-        }
+        spectrogramView.release();
     }
-    while (pathProducer.getNumPathsAvailable())
+
+    pathProducer.setView(view);
+
+    //the overlay is only drawn over the lines
+    updatePreAnalyzerTap();
+
+    analyzerLayerDirty = true;
+    repaint(getRenderArea());
+}
+
+void ResponseCurveComponent::mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel)
+{
+    if (analyzerView != AnalyzerView::Spectrogram || !spectrogramView.isAllocated())
     {
-        pathProducer.getPath(leftChannelFFTPath);
+        juce::Component::mouseWheelMove(event, wheel);
+        return;
     }
+
+    //up goes back in time; scrolling all the way down follows the input again
+    auto columns = juce::roundToInt(wheel.deltaY * float(getAnalysisArea().getWidth()));
+    spectrogramView.setScrollback(spectrogramView.getScrollback() + columns);
+
+    analyzerLayerDirty = true;
+    repaint(getRenderArea());
+}
+
+size_t ResponseCurveComponent::getAnalyzerMemoryUsage() const
+{
+    return pathProducer.getMemoryUsage()
+        + prePathProducer.getMemoryUsage()
+        + spectrogramView.getMemoryUsage()
+        + audioProcessor.getAnalyzerMemoryUsage();
 }
 
 void ResponseCurveComponent::timerCallback()
@@ -351,23 +1673,112 @@ void ResponseCurveComponent::timerCallback()
     //{
     //    pathProducer.getPath(leftChannelFFTPath);
     //}
-    if (displayFFTAnalysis)
-    {
-        auto fftBounds = getAnalysisArea().toFloat();
-        auto sampleRate = audioProcessor.getSampleRate();
+    //hidden or minimised: nothing to draw, so just poll slowly for coming back
+    auto showing = isShowing();
+    analysisPaused.store(!showing);
+
+    if (hasPainted && !isRegisteredForAnalysis)
+        updateAnalyzerTap(true);
 
-        leftPathProducer.process(fftBounds, sampleRate);
-        rightPathProducer.process(fftBounds, sampleRate);
+    if (!showing)
+    {
+        setTimerRate(idleRateHz);
+        return;
     }
 
-    if (parametersChanged.compareAndSetBool(false, true))
+    auto changed = displayFFTAnalysis && pullAnalysis();
+
+    auto sampleRate = audioProcessor.getSampleRate();
+    if (parametersChanged.compareAndSetBool(false, true) || sampleRate != responseCurveSampleRate)
     {
         DBG("params changed");
+        responseCurveSampleRate = sampleRate;
         updateChain();
 
-        //repaint();
+        //only the strip the curve moved through needs repainting
+        auto oldBounds = responseCurve.getBounds();
+        updateResponseCurve();
+        repaint(oldBounds.getUnion(responseCurve.getBounds()).expanded(2.f).getSmallestIntegerContainer());
+        changed = true;
+    }
+
+    //nothing changed: an idle editor doesn't repaint at all
+
+    //silent input stops the analysis, so once the knobs have been still for a
+    //moment too there's nothing left to tick for
+    auto silent = isRegisteredForAnalysis && pathProducer.isInputSilent()
+        && (!isPreTapActive || prePathProducer.isInputSilent());
+
+    auto now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    if (changed || !silent)
+        lastActivityTime = now;
+
+    if (now - lastActivityTime > idleAfterSeconds)
+    {
+        paintSecondsSinceLastTick = 0;
+        analysisTicksSinceLastTick.store(0);
+        setTimerRate(idleRateHz);
+        return;
+    }
+
+    updateFrameRate();
+}
+
+bool ResponseCurveComponent::pullAnalysis()
+{
+    {
+        const juce::SpinLock::ScopedLockType sl(analysisSettingsLock);
+        analysisBounds = getAnalysisArea().toFloat();
+        analysisSampleRate = audioProcessor.getSampleRate();
+    }
+
+    auto gotNewAnalysis = pathProducer.pullLatestPaths();
+
+    if (isPreTapActive)
+        gotNewAnalysis |= prePathProducer.pullLatestPaths();
+
+    while (auto* column = pathProducer.acquireSpectrogramColumn())
+    {
+        spectrogramView.pushColumn(*column);
+        pathProducer.releaseSpectrogramColumn();
+        gotNewAnalysis = true;
+    }
+
+    //traces can overshoot the analysis area a little, so repaint the whole plot
+    if (gotNewAnalysis)
+    {
+        analyzerLayerDirty = true;
+        repaint(getRenderArea());
     }
-    repaint();
+
+    return gotNewAnalysis;
+}
+
+void ResponseCurveComponent::setTimerRate(int rateHz)
+{
+    if (rateHz == timerRateHz)
+        return;
+
+    timerRateHz = rateHz;
+    timerIsIdle.store(rateHz == idleRateHz);
+    startTimerHz(timerRateHz);
+}
+
+void ResponseCurveComponent::updateFrameRate()
+{
+    auto analysisSeconds = juce::Time::highResolutionTicksToSeconds(analysisTicksSinceLastTick.exchange(0));
+    auto spent = paintSecondsSinceLastTick + analysisSeconds;
+    paintSecondsSinceLastTick = 0;
+
+    frameRate.addFrame(spent);
+
+    if (frameRate.getRateHz() == timerRateHz)
+        return;
+
+    setTimerRate(frameRate.getRateHz());
+
+    //the scheduler ticks at its own fixed rate; skip its frames to match ours
+    analysisFrameInterval.store(juce::jmax(1, juce::roundToInt(double(AnalysisScheduler::frameRateHz) / timerRateHz)));
 }
 
 
@@ -389,170 +1800,218 @@ void ResponseCurveComponent::updateChain()
     updateCutFilter(monoChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
 }
 
-int startSubPath(
-    juce::Path& responseCurve,
-    const std::vector <double>& map,
-    const std::vector<double> &mins,
-    const float& x)
+void ResponseCurveComponent::paint(juce::Graphics& g)
 {
-    bool isFoundStart = false;
-    if (map.front() <= mins.front())
+    using namespace juce;
+
+    auto paintStart = Time::getHighResolutionTicks();
+
+    //every layer is cached; paint only re-renders the ones marked dirty and then blits
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (!isLayerSized(background, scale))
+        renderBackground(scale);
+
+    g.drawImage(background, getLocalBounds().toFloat());
+
+    if (displayFFTAnalysis && analyzerView == AnalyzerView::Spectrogram)
     {
-        isFoundStart = true;
-        responseCurve.startNewSubPath(x, map.front());
+        //let the grid show through
+        g.setOpacity(0.85f);
+        spectrogramView.draw(g, getAnalysisArea());
+        g.setOpacity(1.f);
     }
-    int j = 1;
-    while (!isFoundStart && j < map.size())
+
+    if (responseCurveNeedsUpdate)
+        updateResponseCurve();
+
+    if (responseCurveLayerDirty || !isLayerSized(responseCurveLayer, scale))
+        renderResponseCurveLayer(scale);
+
+    g.drawImage(responseCurveLayer, getLocalBounds().toFloat());
+
+    if (displayFFTAnalysis && analyzerView == AnalyzerView::Lines)
     {
-        if (map[j] <= mins[j])
-        {
-            responseCurve.startNewSubPath(x + j - 1, mins[j]);
-            responseCurve.lineTo(x + j, map[j]);
-            isFoundStart = true;
-        }
-        j++;
+        if (traceRasterizer.prepare(getWidth(), getHeight(), scale) || analyzerLayerDirty)
+            renderAnalyzerLayer();
+
+        traceRasterizer.draw(g, getLocalBounds().toFloat());
     }
-    return j;
+
+    hasPainted = true;
+    paintSecondsSinceLastTick += Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - paintStart);
 }
 
-void ResponseCurveComponent::paint(juce::Graphics& g)
+bool ResponseCurveComponent::isLayerSized(const juce::Image& layer, float scale) const
+{
+    return layer.isValid()
+        && layer.getWidth() == juce::roundToInt(getWidth() * scale)
+        && layer.getHeight() == juce::roundToInt(getHeight() * scale);
+}
+
+void ResponseCurveComponent::renderResponseCurveLayer(float scale)
 {
     using namespace juce;
 
-    auto responseArea = getAnalysisArea();
-    /*auto fillArea = getRenderArea();
-    */
-    //Rectangle<float> bg(fillArea.getX(), fillArea.getY(), fillArea.getWidth(), fillArea.getHeight());
-    /*
-    g.setColour(Colours::olive);
-    g.fillRoundedRectangle(bg, 5.f);
-    */
+    responseCurveLayerDirty = false;
 
-    g.drawImage(background, getLocalBounds().toFloat());
+    if (!isLayerSized(responseCurveLayer, scale))
+    {
+        auto width = roundToInt(getWidth() * scale);
+        auto height = roundToInt(getHeight() * scale);
+        responseCurveLayer = width > 0 && height > 0
+            ? Image(Image::PixelFormat::ARGB, width, height, true, SoftwareImageType())
+            : Image();
+    }
 
-    auto w = responseArea.getWidth();
+    if (!responseCurveLayer.isValid())
+        return;
 
-    auto& lowCut = monoChain.get < ChainPositions::LowCut>();
-    auto& peak = monoChain.get<ChainPositions::Peak>();
-    auto& highCut = monoChain.get<ChainPositions::HighCut>();
-    auto sampleRate = audioProcessor.getSampleRate();
+    responseCurveLayer.clear(responseCurveLayer.getBounds());
+
+    Graphics g(responseCurveLayer);
+    g.addTransform(AffineTransform::scale(scale));
+    g.setColour(Colours::white);
+    g.strokePath(responseCurve, PathStrokeType(1.f));
+}
 
-    std::vector<double> mags;
+void ResponseCurveComponent::renderAnalyzerLayer()
+{
+    using namespace juce;
 
-    mags.resize(w);
+    analyzerLayerDirty = false;
 
-    for (int i = 0; i < w; i++)
-    {
-        double mag = 1.f;
-        auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
+    //rasterized straight into pixels; stroking these every frame was the bulk of paint
+    traceRasterizer.beginFrame();
 
-        if (!monoChain.isBypassed<ChainPositions::Peak>())
-        {
-            mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
+    auto offset = getRenderArea().getPosition().toFloat();
 
-        if (!monoChain.isBypassed<ChainPositions::LowCut>())
-        {
-            if (!lowCut.isBypassed<0>())
-                mag *= lowCut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if (!lowCut.isBypassed<1>())
-                mag *= lowCut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if (!lowCut.isBypassed<2>())
-                mag *= lowCut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if (!lowCut.isBypassed<3>())
-                mag *= lowCut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-        if (!monoChain.isBypassed<ChainPositions::HighCut>())
-        {
-            if (!highCut.isBypassed<0>())
-                mag *= highCut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if (!highCut.isBypassed<1>())
-                mag *= highCut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if (!highCut.isBypassed<2>())
-                mag *= highCut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if (!highCut.isBypassed<3>())
-                mag *= highCut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-        mags[i] = Decibels::gainToDecibels(mag);
-    }
+    if (isPreTapActive)
+        traceRasterizer.drawPolyline(prePathProducer.getPath(0), Colours::lightgrey.withAlpha(0.5f), offset);
+
+    traceRasterizer.drawPolyline(pathProducer.getPath(0), Colours::olive, offset);
+    traceRasterizer.drawPolyline(pathProducer.getPath(1), Colours::olivedrab, offset);
+}
+
+void ResponseCurveComponent::updateResponseCurve()
+{
+    using namespace juce;
 
-    Path responseCurve;
+    responseCurveNeedsUpdate = false;
+    responseCurveLayerDirty = true;
+    responseCurve.clear();
 
-    responseArea = getRenderArea();
+    auto w = getAnalysisArea().getWidth();
+    if (w <= 0 || responseCurveSampleRate <= 0)
+        return;
+
+    //only reallocates when the component gets wider
+    auto& mags = responseCurveMagnitudes;
+    mags.resize((size_t)w);
+
+    //all sections over all columns in one batch; the trig tables only change with the width or sample rate
+    responseEvaluator.setLogGrid(w, 20.0, 20000.0, responseCurveSampleRate);
+    snapshotChain(monoChain, responseSnapshot);
+    responseEvaluator.computeDecibels(responseSnapshot, mags.data());
+
+    auto responseArea = getRenderArea();
 
     const double outputMin = responseArea.getBottom();
     const double outputMax = responseArea.getY();
     auto map = [outputMin, outputMax](double input)
     {
-
         return jmap(input, -24.0, 24.0, outputMin, outputMax);
     };
-    std::vector<double> mmags;
-    mmags.resize(w);
-    for (int i = 0; i < w; i++)
-    {
-        mmags[i] = map(mags[i]);
-    }
 
-    std::vector<double> outputMins;
-    outputMins.resize(w);
-    for (int i = 0; i < w; i++)
-    {
-        outputMins[i] = outputMin;
-    }
-    std::vector<double> curve{ 15, 11, 8, 6, 5, 4, 4, 3, 3, 3, 2, 2, 2, 2 };
-    for (int i = 0; i < curve.size(); i++)
+    //the curve is clipped at the bottom edge, which rises into the rounded corners at either end
+    static constexpr double cornerRise[]{ 15, 11, 8, 6, 5, 4, 4, 3, 3, 3, 2, 2, 2, 2 };
+    constexpr int cornerWidth = (int)std::size(cornerRise);
+    auto clipAt = [w, outputMin](int i)
     {
-        outputMins[i] -= curve[i];
-    }
-    for (int i = 0; i < curve.size(); i++)
-    {
-        outputMins[w - i - 1] -= curve[i];
-    }
-
-    int j = startSubPath(responseCurve, mmags, outputMins, responseArea.getX());
+        auto clip = outputMin;
+        if (i < cornerWidth)
+            clip -= cornerRise[i];
+        if (w - 1 - i < cornerWidth)
+            clip -= cornerRise[w - 1 - i];
+        return clip;
+    };
 
-    while (j < mmags.size())
+    //one pass: a sub-path runs while the curve is above the clip line, ends on
+    //the line where it dips below, and restarts from the line where it comes back
+    auto x = (float)responseArea.getX();
+    bool drawing = false;
+    for (int i = 0; i < w; ++i)
     {
-        if (mmags[j] < outputMins[j])
-        {
-            responseCurve.lineTo(responseArea.getX() + j, mmags[j]);
-        }
-        else if (mmags[j] >= outputMins[j])
+        auto y = map(mags[i]);
+        auto clip = clipAt(i);
+
+        if (y < clip)
         {
-            responseCurve.lineTo(responseArea.getX() + j, outputMins[j]);
-            std::vector <double> sub(&mmags[j], &mmags[mmags.size() - 1]);
-            if (!sub.empty())
+            if (drawing)
             {
-                j += startSubPath(responseCurve, sub, outputMins, responseArea.getX() + j);
+                responseCurve.lineTo(x + i, (float)y);
             }
+            else if (i == 0)
+            {
+                responseCurve.startNewSubPath(x, (float)y);
+            }
+            else
+            {
+                responseCurve.startNewSubPath(x + i - 1, (float)clipAt(i - 1));
+                responseCurve.lineTo(x + i, (float)y);
+            }
+
+            drawing = true;
+        }
+        else if (drawing)
+        {
+            responseCurve.lineTo(x + i, (float)clip);
+            drawing = false;
         }
-        j++;
     }
-    g.setColour(Colours::white);
-    g.strokePath(responseCurve, PathStrokeType(1.f));
+}
 
-    if (displayFFTAnalysis)
-    {
-        auto leftChannelFFTPath = leftPathProducer.getPath();
-        leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
-        auto rightChannelFFTPath = rightPathProducer.getPath();
-        rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
+void ResponseCurveComponent::resized()
+{
+    //everything is re-rendered lazily by the next paint
+    responseCurveNeedsUpdate = true;
+    analyzerLayerDirty = true;
 
-        g.setColour(Colours::olive);
-        g.strokePath(leftChannelFFTPath, PathStrokeType(1.f, PathStrokeType::JointStyle::beveled));
-        g.setColour(Colours::olivedrab);
-        g.strokePath(rightChannelFFTPath, PathStrokeType(1.f, PathStrokeType::JointStyle::beveled));
-    }
+    spectrogramView.setSize(getAnalysisArea().getWidth(), getAnalysisArea().getHeight());
 }
 
-void ResponseCurveComponent::resized()
+void ResponseCurveComponent::renderBackground(float scale)
 {
     using namespace juce;
-    background = Image(Image::PixelFormat::RGB, getWidth(), getHeight(), true);
-    
+
+    auto width = roundToInt(getWidth() * scale);
+    auto height = roundToInt(getHeight() * scale);
+
+    if (width <= 0 || height <= 0)
+    {
+        background = Image();
+        return;
+    }
+
+    auto hashCode = String("SimpleEQ response background " + String(width) + "x" + String(height)
+        + "@" + String(scale)).hashCode64();
+
+    background = ImageCache::getFromHashCode(hashCode);
+    if (background.isValid())
+        return;
+
+    background = Image(Image::PixelFormat::RGB, width, height, true, SoftwareImageType());
 
     Graphics g(background);
+    g.addTransform(AffineTransform::scale(scale));
+    drawBackground(g);
+
+    ImageCache::addImageToCache(background, hashCode);
+}
+
+void ResponseCurveComponent::drawBackground(juce::Graphics& g)
+{
+    using namespace juce;
 
     auto fillArea = getRenderArea();
 
@@ -755,10 +2214,10 @@ SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor(SimpleEQAudioProcesso
         addAndMakeVisible(comp);
     }
 
-    peakBypassedButton.setLookAndFeel(&lnf);
-    lowCutBypassedButton.setLookAndFeel(&lnf);
-    highCutBypassedButton.setLookAndFeel(&lnf);
-    analyzerEnabledButton.setLookAndFeel(&lnf);
+    peakBypassedButton.setLookAndFeel(&lnf.get());
+    lowCutBypassedButton.setLookAndFeel(&lnf.get());
+    highCutBypassedButton.setLookAndFeel(&lnf.get());
+    analyzerEnabledButton.setLookAndFeel(&lnf.get());
 
     auto safePtr = juce::Component::SafePointer<SimpleEQAudioProcessorEditor>(this);
     peakBypassedButton.onClick = [safePtr]()
@@ -802,12 +2261,87 @@ SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor(SimpleEQAudioProcesso
         }
     };
 
+    analyzerResolutionBox.addItem("2048", FFTOrder::order2048);
+    analyzerResolutionBox.addItem("4096", FFTOrder::order4096);
+    analyzerResolutionBox.addItem("8192", FFTOrder::order8192);
+    analyzerResolutionBox.setSelectedId(FFTOrder::order2048, juce::dontSendNotification);
+    analyzerResolutionBox.onChange = [safePtr]()
+    {
+        if (auto comp = safePtr.getComponent())
+        {
+            auto order = static_cast<FFTOrder>(comp->analyzerResolutionBox.getSelectedId());
+            comp->responseCurveComponent.setAnalyzerOrder(order);
+        }
+    };
+
+    analyzerChannelModeBox.addItem("L / R", AnalyzerChannelMode::LeftRight + 1);
+    analyzerChannelModeBox.addItem("M / S", AnalyzerChannelMode::MidSide + 1);
+    analyzerChannelModeBox.setSelectedId(AnalyzerChannelMode::LeftRight + 1, juce::dontSendNotification);
+    analyzerChannelModeBox.onChange = [safePtr]()
+    {
+        if (auto comp = safePtr.getComponent())
+        {
+            auto mode = static_cast<AnalyzerChannelMode>(comp->analyzerChannelModeBox.getSelectedId() - 1);
+            comp->responseCurveComponent.setAnalyzerChannelMode(mode);
+        }
+    };
+
+    analyzerEngineBox.addItem("FFT", AnalyzerEngine::FFT + 1);
+    analyzerEngineBox.addItem("CQT", AnalyzerEngine::ConstantQ + 1);
+    analyzerEngineBox.setSelectedId(AnalyzerEngine::FFT + 1, juce::dontSendNotification);
+    analyzerEngineBox.onChange = [safePtr]()
+    {
+        if (auto comp = safePtr.getComponent())
+        {
+            auto engine = static_cast<AnalyzerEngine>(comp->analyzerEngineBox.getSelectedId() - 1);
+            comp->responseCurveComponent.setAnalyzerEngine(engine);
+
+            //the constant-Q engine has a fixed resolution
+            comp->analyzerResolutionBox.setEnabled(engine == AnalyzerEngine::FFT);
+            comp->analyzerSmoothingBox.setEnabled(engine == AnalyzerEngine::FFT);
+        }
+    };
+
+    analyzerSmoothingBox.addItem("Raw", AnalyzerSmoothing::NoSmoothing + 1);
+    analyzerSmoothingBox.addItem("1/3 oct", AnalyzerSmoothing::ThirdOctave + 1);
+    analyzerSmoothingBox.addItem("1/6 oct", AnalyzerSmoothing::SixthOctave + 1);
+    analyzerSmoothingBox.addItem("1/12 oct", AnalyzerSmoothing::TwelfthOctave + 1);
+    analyzerSmoothingBox.setSelectedId(AnalyzerSmoothing::NoSmoothing + 1, juce::dontSendNotification);
+    analyzerSmoothingBox.onChange = [safePtr]()
+    {
+        if (auto comp = safePtr.getComponent())
+        {
+            auto smoothing = static_cast<AnalyzerSmoothing>(comp->analyzerSmoothingBox.getSelectedId() - 1);
+            comp->responseCurveComponent.setAnalyzerSmoothing(smoothing);
+        }
+    };
+
+    preEQOverlayButton.onClick = [safePtr]()
+    {
+        if (auto comp = safePtr.getComponent())
+            comp->responseCurveComponent.setPreEQOverlayVisible(comp->preEQOverlayButton.getToggleState());
+    };
+
+    analyzerViewBox.addItem("Lines", AnalyzerView::Lines + 1);
+    analyzerViewBox.addItem("Spectro", AnalyzerView::Spectrogram + 1);
+    analyzerViewBox.setSelectedId(AnalyzerView::Lines + 1, juce::dontSendNotification);
+    analyzerViewBox.onChange = [safePtr]()
+    {
+        if (auto comp = safePtr.getComponent())
+        {
+            auto view = static_cast<AnalyzerView>(comp->analyzerViewBox.getSelectedId() - 1);
+            comp->responseCurveComponent.setAnalyzerView(view);
+        }
+    };
+
     setSize (600, 480);
 }
 
     void ResponseCurveComponent::toggleAnalysisEnablement(bool enabled)
     {
         displayFFTAnalysis = enabled;
+        updateAnalyzerTap(true);
+        setAnalyzerView(analyzerView);
     }
 
 SimpleEQAudioProcessorEditor::~SimpleEQAudioProcessorEditor()
@@ -830,12 +2364,23 @@ void SimpleEQAudioProcessorEditor::resized()
 {
     auto bounds = getLocalBounds();
 
-    auto analyzerEnabledButtonArea = bounds.removeFromTop(25);
-    analyzerEnabledButtonArea.setWidth(100);
-    analyzerEnabledButtonArea.setX(5);
-    analyzerEnabledButtonArea.removeFromTop(2);
-
-    analyzerEnabledButton.setBounds(analyzerEnabledButtonArea);
+    auto analyzerControlsArea = bounds.removeFromTop(25);
+    analyzerControlsArea.removeFromTop(2);
+    analyzerControlsArea.removeFromLeft(5);
+
+    analyzerEnabledButton.setBounds(analyzerControlsArea.removeFromLeft(100));
+    analyzerControlsArea.removeFromLeft(5);
+    analyzerChannelModeBox.setBounds(analyzerControlsArea.removeFromLeft(70));
+    analyzerControlsArea.removeFromLeft(5);
+    analyzerResolutionBox.setBounds(analyzerControlsArea.removeFromLeft(70));
+    analyzerControlsArea.removeFromLeft(5);
+    analyzerEngineBox.setBounds(analyzerControlsArea.removeFromLeft(70));
+    analyzerControlsArea.removeFromLeft(5);
+    analyzerSmoothingBox.setBounds(analyzerControlsArea.removeFromLeft(80));
+    analyzerControlsArea.removeFromLeft(5);
+    analyzerViewBox.setBounds(analyzerControlsArea.removeFromLeft(80));
+    analyzerControlsArea.removeFromLeft(5);
+    preEQOverlayButton.setBounds(analyzerControlsArea.removeFromLeft(70));
     bounds.removeFromTop(5);
 
     float hRatio = 25.F / 100.f; //JUCE_LIVE_CONSTANT(29) / 100.f;
@@ -880,6 +2425,12 @@ std::vector<juce::Component*> SimpleEQAudioProcessorEditor::getComps()
         &lowCutBypassedButton,
         &peakBypassedButton,
         &highCutBypassedButton,
-        &analyzerEnabledButton
+        &analyzerEnabledButton,
+        &analyzerChannelModeBox,
+        &analyzerResolutionBox,
+        &analyzerEngineBox,
+        &analyzerSmoothingBox,
+        &analyzerViewBox,
+        &preEQOverlayButton
     };
 }
\ No newline at end of file
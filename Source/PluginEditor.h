@@ -9,7 +9,9 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <bit>
 #include "PluginProcessor.h"
+#include "FrequencyResponse.h"
 
 
 enum FFTOrder
@@ -19,104 +21,500 @@ enum FFTOrder
     order8192 = 13
 };
 
+/*
+ process-wide cache of window tables, shared by every FFTDataGenerator in
+ every plugin instance. an entry lives for as long as some generator holds
+ it, so opening more editors doesn't add copies.
+
+ fft plans aren't shared: juce's fallback engine guards the working state
+ inside a plan with a spinlock, so analyzers sharing a plan would queue on
+ each other across the scheduler's workers. each generator builds its own.
+ */
+struct FFTResourceCache
+{
+    using WindowingMethod = juce::dsp::WindowingFunction<float>::WindowingMethod;
+
+    std::shared_ptr<const std::vector<float>> getWindow(int size, WindowingMethod method);
+
+private:
+    juce::CriticalSection lock;
+    std::map<std::pair<int, int>, std::weak_ptr<const std::vector<float>>> windows;
+};
+
+/**
+ log2 for positive, normal floats: the exponent bits plus an atanh series on
+ the mantissa. branch-free so loops over it vectorise; error is below 2e-5.
+ */
+inline float fastLog2(float x) noexcept
+{
+    auto bits = std::bit_cast<juce::uint32>(x);
+    auto exponent = float(int(bits >> 23) - 127);
+    auto mantissa = std::bit_cast<float>((bits & 0x007fffffu) | 0x3f800000u);
+
+    auto t = (mantissa - 1.f) / (mantissa + 1.f);
+    auto t2 = t * t;
+
+    return exponent + t * (2.8853901f + t2 * (0.9617967f + t2 * (0.5770780f + t2 * 0.4121986f)));
+}
+
+/**
+ 2^x with the same bit tricks as fastLog2: a polynomial for the fraction,
+ added straight into the exponent bits. relative error is below 1e-4.
+ */
+inline float fastExp2(float x) noexcept
+{
+    x = x < -126.f ? -126.f : (x > 126.f ? 126.f : x);
+    auto whole = std::floor(x);
+    auto f = x - whole;
+    auto mantissa = 1.f + f * (0.6931472f + f * (0.2402265f + f * (0.0555041f + f * (0.0096181f + f * 0.0013334f))));
+
+    return std::bit_cast<float>(std::bit_cast<juce::uint32>(mantissa) + (juce::uint32(int(whole)) << 23));
+}
+
+/**
+ turns the interleaved complex bins of a real fft into normalised decibels in
+ one pass. powers that would land below negativeInfinity, and nan/inf, are
+ floored to negativeInfinity, matching Decibels::gainToDecibels.
+ */
+inline void convertBinsToDecibels(const float* __restrict complexBins,
+    float* __restrict decibels,
+    int numBins,
+    float negativeInfinity)
+{
+    constexpr float decibelsPerOctave = 3.0103f; // 10 * log10(2)
+    const auto normalisation = -20.f * std::log10(float(numBins));
+    const auto minPower = std::pow(10.f, (negativeInfinity - normalisation) / 10.f);
+    const auto maxPower = std::numeric_limits<float>::max();
+
+    for (int i = 0; i < numBins; ++i)
+    {
+        auto re = complexBins[2 * i];
+        auto im = complexBins[2 * i + 1];
+        auto power = re * re + im * im;
+
+        //both comparisons are false for nan, and inf fails the second
+        power = (power >= minPower && power <= maxPower) ? power : minPower;
+
+        auto db = decibelsPerOctave * fastLog2(power) + normalisation;
+        decibels[i] = db > negativeInfinity ? db : negativeInfinity;
+    }
+}
+
+/** turns a and b into mid = (a + b) / 2 and side = (a - b) / 2, in place */
+inline void convertToMidSide(float* a, float* b, int numSamples)
+{
+    juce::FloatVectorOperations::add(a, b, numSamples);
+    juce::FloatVectorOperations::multiply(a, 0.5f, numSamples);
+    juce::FloatVectorOperations::subtract(b, a, b, numSamples);
+}
+
 template<typename BlockType>
 struct FFTDataGenerator
 {
     /**
      produces the FFT data from an audio buffer.
+     with two channels the spectra are laid out one after the other in the
+     block, channel 0's bins first.
      */
     void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
     {
-        const auto fftSize = getFFTSize();
-
-        fftData.assign(fftData.size(), 0);
-        auto* readIndex = audioData.getReadPointer(0);
-        std::copy(readIndex, readIndex + fftSize, fftData.begin());
-
-        // first apply a windowing function to our data
-        window->multiplyWithWindowingTable(fftData.data(), fftSize);       // [1]
-
-        // then render our FFT data..
-        forwardFFT->performFrequencyOnlyForwardTransform(fftData.data());  // [2]
-
-        int numBins = (int)fftSize / 2;
+        jassert(audioData.getNumChannels() >= numChannels);
 
-        //normalize the fft values.
-        for (int i = 0; i < numBins; ++i)
-        {
-            auto v = fftData[i];
-            //            fftData[i] /= (float) numBins;
-            if (!std::isinf(v) && !std::isnan(v))
-            {
-                v /= float(numBins);
-            }
-            else
-            {
-                v = 0.f;
-            }
-            fftData[i] = v;
-        }
+        //work directly in the next free fifo slot; if the consumer is behind, drop this frame
+        auto* slot = fftDataFifo.acquireWrite();
+        if (slot == nullptr)
+            return;
 
-        //convert them to decibels
-        for (int i = 0; i < numBins; ++i)
-        {
-            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
-        }
+        if (numChannels == 2)
+            produceStereoSpectra(audioData.getReadPointer(0), audioData.getReadPointer(1), slot->data(), negativeInfinity);
+        else
+            produceMonoSpectrum(audioData.getReadPointer(0), slot->data(), negativeInfinity);
 
-        fftDataFifo.push(fftData);
+        fftDataFifo.commitWrite();
     }
 
-    void changeOrder(FFTOrder newOrder)
+    /*
+     when you change order, build this generator's forwardFFT, fetch the window from the shared cache and resize the fifo.
+     the plan and window for each order are kept until release(), and once the generator has been at a given
+     order and channel count, switching to that size or any smaller one reuses the existing storage. so after
+     every order has been visited once, a switch neither allocates nor takes the cache's lock.
+     */
+    void changeOrder(FFTOrder newOrder, int newNumChannels = 1)
     {
-        //when you change order, recreate the window, forwardFFT, fifo, fftData
-        //also reset the fifoIndex
-        //things that need recreating should be created on the heap via std::make_unique<>
+        jassert(newNumChannels == 1 || newNumChannels == 2);
 
         order = newOrder;
+        numChannels = newNumChannels;
         auto fftSize = getFFTSize();
 
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
+        auto& resources = orderResources[size_t(order - FFTOrder::order2048)];
+        if (resources.fft == nullptr)
+        {
+            resources.fft = std::make_unique<juce::dsp::FFT>(order);
+            resources.window = resourceCache->getWindow(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
+        }
 
-        fftData.clear();
-        fftData.resize(fftSize * 2, 0);
+        forwardFFT = resources.fft.get();
+        window = resources.window.get();
 
-        fftDataFifo.prepare(fftData.size());
+        //the transforms need 2 * fftSize of room per channel, but only the bins are handed on
+        fftWorkspace.assign(fftSize * 2 * numChannels, 0);
+        fftDataFifo.prepare(fftSize / 2 * numChannels);
+    }
+    //==============================================================================
+    /** frees the ffts, windows and fifo storage until the next changeOrder() */
+    void release()
+    {
+        forwardFFT = nullptr;
+        window = nullptr;
+        orderResources = {};
+        fftWorkspace = {};
+        fftDataFifo.release();
     }
+
+    size_t getMemoryUsage() const { return fftDataFifo.getMemoryUsage() + fftWorkspace.capacity() * sizeof(float); }
     //==============================================================================
     int getFFTSize() const { return 1 << order; }
+    FFTOrder getOrder() const { return order; }
+    int getNumChannels() const { return numChannels; }
     int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
     //==============================================================================
     bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
+
+    /** in-place access to the oldest spectrum; pair with releaseFFTData() */
+    const BlockType* acquireFFTData() { return fftDataFifo.acquireRead(); }
+    void releaseFFTData() { fftDataFifo.releaseRead(); }
 private:
-    FFTOrder order;
-    BlockType fftData;
-    std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    FFTOrder order = FFTOrder::order2048;
+    juce::SharedResourcePointer<FFTResourceCache> resourceCache;
+
+    struct OrderResources
+    {
+        std::unique_ptr<juce::dsp::FFT> fft;
+        std::shared_ptr<const std::vector<float>> window;
+    };
+
+    //indexed by order - order2048
+    std::array<OrderResources, 3> orderResources;
+    const juce::dsp::FFT* forwardFFT = nullptr;
+    const std::vector<float>* window = nullptr;
+    std::vector<float> fftWorkspace;
+    int numChannels = 1;
 
     Fifo<BlockType> fftDataFifo;
+
+    void produceMonoSpectrum(const float* input, float* decibels, float negativeInfinity)
+    {
+        const auto fftSize = getFFTSize();
+        auto* workspace = fftWorkspace.data();
+
+        // window while copying in. the transform only reads the first fftSize
+        // values and overwrites the rest, so nothing needs clearing.
+        juce::FloatVectorOperations::multiply(workspace, input, window->data(), fftSize);  // [1]
+
+        // then render our FFT data..
+        forwardFFT->performRealOnlyForwardTransform(workspace, true);  // [2]
+
+        // magnitude, normalisation and decibels in one pass, straight into the slot
+        convertBinsToDecibels(workspace, decibels, fftSize / 2, negativeInfinity);
+    }
+
+    /*
+     two real signals through one complex fft: pack a into the real part and
+     b into the imaginary part, transform once, then split the spectra using
+     A[k] = (Z[k] + conj(Z[N-k])) / 2 and B[k] = (Z[k] - conj(Z[N-k])) / 2i.
+     */
+    void produceStereoSpectra(const float* a, const float* b, float* decibels, float negativeInfinity)
+    {
+        const auto fftSize = getFFTSize();
+        const auto numBins = fftSize / 2;
+        auto* packed = fftWorkspace.data();
+        auto* transformed = packed + fftSize * 2;
+        const auto* windowTable = window->data();
+
+        for (int n = 0; n < fftSize; ++n)
+        {
+            packed[2 * n] = a[n] * windowTable[n];
+            packed[2 * n + 1] = b[n] * windowTable[n];
+        }
+
+        using Complex = juce::dsp::Complex<float>;
+        forwardFFT->perform(reinterpret_cast<const Complex*>(packed), reinterpret_cast<Complex*>(transformed), false);
+
+        //the packed input isn't needed any more, so reuse it for the two separated spectra
+        auto* spectrumA = packed;
+        auto* spectrumB = packed + fftSize;
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            auto mirror = (fftSize - k) & (fftSize - 1);
+            auto zr = transformed[2 * k], zi = transformed[2 * k + 1];
+            auto mr = transformed[2 * mirror], mi = transformed[2 * mirror + 1];
+
+            spectrumA[2 * k] = 0.5f * (zr + mr);
+            spectrumA[2 * k + 1] = 0.5f * (zi - mi);
+            spectrumB[2 * k] = 0.5f * (zi + mi);
+            spectrumB[2 * k + 1] = 0.5f * (mr - zr);
+        }
+
+        convertBinsToDecibels(spectrumA, decibels, numBins, negativeInfinity);
+        convertBinsToDecibels(spectrumB, decibels + numBins, numBins, negativeInfinity);
+    }
+};
+
+/*
+ constant-Q style analyzer: each channel is split into octaves by a cascade of
+ halfband decimators, and every octave gets a small fft at its own sample rate.
+ the low octaves see a long stretch of audio through a short transform, so the
+ bass gets 8192-point resolution for less than the cost of one 2048-point fft.
+ the result is resampled onto numPoints log-spaced frequencies from 20 Hz to
+ 20 kHz, ready to be drawn straight across the display.
+ */
+struct MultirateSpectrumGenerator
+{
+    static constexpr int numStages = 6;
+    static constexpr int stageOrder = 8;
+    static constexpr int stageSize = 1 << stageOrder;
+    static constexpr int numPoints = 512;
+
+    /** allocates everything; the other members don't */
+    void prepare(int numChannels);
+    void release();
+    void reset();
+
+    /**
+     feeds new audio through the decimator cascade. with midSide, a and b are
+     analysed as (a+b)/2 and (a-b)/2. a mono generator analyses (a+b)/2, or
+     just a when b is null.
+     */
+    void pushSamples(const float* a, const float* b, int numSamples, bool midSide);
+
+    /** runs the per-octave ffts and pushes numPoints dB values per channel, channel 0 first */
+    void produceSpectrumForRendering(double sampleRate, float negativeInfinity);
+
+    const std::vector<float>* acquireSpectrum() { return spectrumFifo.acquireRead(); }
+    void releaseSpectrum() { spectrumFifo.releaseRead(); }
+
+    size_t getMemoryUsage() const;
+
+private:
+    //11-tap lagrange halfband: every other tap but the centre is zero
+    struct HalfbandDecimator
+    {
+        bool push(float x, float& y)
+        {
+            delay[pos] = delay[pos + numTaps] = x;
+            pos = (pos + 1) % numTaps;
+
+            odd = !odd;
+            if (!odd)
+                return false;
+
+            const auto* w = delay.data() + pos; //oldest first
+            y = (3.f / 512.f) * (w[0] + w[10])
+                + (-25.f / 512.f) * (w[2] + w[8])
+                + (150.f / 512.f) * (w[4] + w[6])
+                + 0.5f * w[5];
+            return true;
+        }
+
+        static constexpr int numTaps = 11;
+        std::array<float, numTaps * 2> delay{};
+        int pos = 0;
+        bool odd = false;
+    };
+
+    struct Stage
+    {
+        std::vector<float> history; //ring of stageSize samples at this stage's rate
+        int writePos = 0;
+        HalfbandDecimator decimator;
+    };
+
+    //where each display point reads its power from
+    struct PointSource
+    {
+        int stage;
+        int bin;
+        float frac;
+    };
+
+    int numChannels = 0;
+    std::vector<std::array<Stage, numStages>> channels;
+    std::vector<float> workspace;
+    std::vector<float> stageDecibels; //stageSize / 2 bins per stage
+    std::vector<PointSource> pointSources;
+    double pointSourcesSampleRate = 0;
+
+    juce::SharedResourcePointer<FFTResourceCache> resourceCache;
+    std::unique_ptr<juce::dsp::FFT> stageFFT;
+    std::shared_ptr<const std::vector<float>> window;
+
+    Fifo<std::vector<float>> spectrumFifo;
+
+    void pushSample(std::array<Stage, numStages>& stages, float x);
+    void updatePointSources(double sampleRate);
+};
+
+/*
+ fractional-octave smoothing of a linear-bin spectrum, sampled once per pixel
+ column. each column averages the power of every bin within 1/n octave of its
+ centre frequency. with a prefix sum over the powers, each average is one
+ subtraction, so a frame costs O(bins + columns) however wide the bands are.
+ the per-column bin ranges only change with the width, fft size or fraction.
+ */
+struct SpectrumSmoother
+{
+    /** sizes the prefix sums for up to maxBins bins */
+    void prepare(int maxBins);
+    void release();
+
+    /**
+     smooths numBins dB values into numColumns log-spaced dB values from 20 Hz
+     to 20 kHz and returns them. 'fraction' is n in 1/n octave. the result
+     stays valid until the next call.
+     */
+    const float* process(const float* decibels,
+        int numBins,
+        double binWidth,
+        int fraction,
+        int numColumns,
+        float negativeInfinity);
+
+    size_t getMemoryUsage() const;
+
+private:
+    struct ColumnRange
+    {
+        int lo, hi;   //inclusive bin range to average
+        float frac;   //when the band is narrower than a bin, interpolate lo -> lo + 1 instead
+        bool interpolate;
+    };
+
+    std::vector<double> prefixSum;
+    std::vector<float> columns;
+    std::vector<ColumnRange> ranges;
+
+    int rangesNumBins = 0;
+    double rangesBinWidth = 0;
+    int rangesFraction = 0;
+
+    void updateRanges(int numBins, double binWidth, int fraction, int numColumns);
+};
+
+/*
+ turns each spectrum the analyzers produce into one spectrogram column: 64
+ log-spaced rows from 20 Hz to 20 kHz, the loudest channel's peak per row,
+ quantized to a byte over [negativeInfinity, 0] dB. runs on the analysis
+ thread and hands the columns to the message thread through a fifo.
+ */
+struct SpectrogramColumnBuilder
+{
+    static constexpr int numRows = 64;
+    using Column = std::array<juce::uint8, numRows>;
+
+    /**
+     'spectra' holds numChannels spectra of numValues dB values back to back.
+     with a binWidth they are linear fft bins; with binWidth == 0 they are
+     already log-spaced from 20 Hz to 20 kHz.
+     */
+    void pushColumn(const float* spectra, int numValues, int numChannels, double binWidth, float negativeInfinity);
+
+    const Column* acquireColumn() { return columnFifo.acquireRead(); }
+    void releaseColumn() { columnFifo.releaseRead(); }
+
+private:
+    //inclusive range of source values that fall into each row
+    std::array<std::pair<int, int>, numRows> rowRanges{};
+    int rangesNumValues = 0;
+    double rangesBinWidth = -1;
+
+    Fifo<Column> columnFifo;
+
+    void updateRowRanges(int numValues, double binWidth);
+};
+
+/*
+ message-thread half of the spectrogram. history is kept as quantized bytes
+ in a ring of historyLength columns, one per analysis frame, so a little over
+ two minutes at 60 Hz costs 512 kB whatever the size of the view. the screen
+ copy is an image of the visible stretch of that history: to scroll, its
+ pixels move left by one and the new column is rendered once at the right
+ edge, so draw() is a single blit. (blitting two halves of a ring-shaped
+ image would cost an allocation per paint, for the subsection images.) the
+ image is only rebuilt from history when the size or the scrollback changes.
+ */
+struct SpectrogramView
+{
+    using Column = SpectrogramColumnBuilder::Column;
+
+    static constexpr size_t maxHistoryBytes = 512 * 1024;
+    static constexpr int historyLength = int(maxHistoryBytes / SpectrogramColumnBuilder::numRows);
+
+    void allocate();
+    void release();
+    bool isAllocated() const { return !history.empty(); }
+    void clear();
+
+    void setSize(int width, int height);
+    void pushColumn(const Column& column);
+    void draw(juce::Graphics& g, juce::Rectangle<int> area) const;
+
+    /** how many columns before the newest the right edge shows. 0 follows the input; otherwise the view holds still. */
+    void setScrollback(int columnsBack);
+    int getScrollback() const { return scrollback; }
+    int getMaxScrollback() const;
+
+    size_t getMemoryUsage() const;
+
+private:
+    std::vector<juce::uint8> history;
+    int historyWritePos = 0;
+    int numColumnsStored = 0;
+    int scrollback = 0;
+
+    juce::Image image;
+
+    std::array<juce::Colour, 256> palette;
+
+    //0 is the newest column
+    const juce::uint8* getStoredColumn(int columnsBack) const;
+    void renderColumn(const juce::uint8* column, int x);
+    void scrollInColumn(const juce::uint8* column);
+    void renderVisibleHistory();
 };
 
 template<typename PathType>
 struct AnalyzerPathGenerator
 {
     /*
-     converts 'renderData[]' into a juce::Path
+     converts 'renderData[]' into a juce::Path.
+     at the top of the display hundreds of bins share a pixel, so the bins are
+     reduced to their min and max per pixel column first; the path never has
+     more than about 2 * width vertices. which bins land in which column is
+     cached and only worked out again when the width or fft size changes.
      */
-    void generatePath(const std::vector<float>& renderData,
+    void generatePath(const float* renderData,
         juce::Rectangle<float> fftBounds,
         int fftSize,
         float binWidth,
         float negativeInfinity)
     {
+        //build straight into the next free slot; its storage is reused from earlier frames
+        auto* slot = pathFifo.acquireWrite();
+        if (slot == nullptr)
+            return;
+
         auto top = fftBounds.getY();
         auto bottom = fftBounds.getHeight();
-        auto width = fftBounds.getWidth();
+        auto numColumns = juce::jmax(1, (int)fftBounds.getWidth());
 
-        int numBins = (int)fftSize / 2;
+        if (fftSize != mapFFTSize || binWidth != mapBinWidth || numColumns != mapNumColumns)
+            updateColumnMap(fftSize, binWidth, numColumns);
 
-        PathType p;
-        p.preallocateSpace(3 * (int)fftBounds.getWidth());
+        PathType& p = *slot;
+        p.clear();
+        p.preallocateSpace(3 * 2 * numColumns);
 
         auto map = [bottom, top, negativeInfinity](float v)
         {
@@ -125,32 +523,70 @@ struct AnalyzerPathGenerator
                 float(bottom + 10), top);
         };
 
-        auto y = map(renderData[0]);
+        p.startNewSubPath(0, map(renderData[0]));
+
+        for (int column = 0; column < numColumns; ++column)
+        {
+            auto first = columnFirstBin[column];
+            auto last = columnFirstBin[column + 1];
+            if (first == last)
+                continue;
+
+            auto lowest = renderData[first];
+            auto highest = lowest;
+            for (int bin = first + 1; bin < last; ++bin)
+            {
+                lowest = juce::jmin(lowest, renderData[bin]);
+                highest = juce::jmax(highest, renderData[bin]);
+            }
+
+            //louder is further up, so draw the peak first, then the dip below it if it shows
+            auto x = float(column);
+            auto peakY = map(highest);
+            auto dipY = map(lowest);
 
-        //        jassert( !std::isnan(y) && !std::isinf(y) );
-        if (std::isnan(y) || std::isinf(y))
-            y = bottom;
+            p.lineTo(x, peakY);
+            if (dipY - peakY >= 1.f)
+                p.lineTo(x, dipY);
+        }
 
-        p.startNewSubPath(0, y);
+        pathFifo.commitWrite();
+    }
 
-        const int pathResolution = 2; //you can draw line-to's every 'pathResolution' pixels.
+    /*
+     converts 'renderData[]' into a juce::Path when its points are already
+     log-spaced from 20 Hz to 20 kHz, as MultirateSpectrumGenerator produces them
+     */
+    void generateLogSpacedPath(const float* renderData,
+        int numPoints,
+        juce::Rectangle<float> fftBounds,
+        float negativeInfinity)
+    {
+        auto* slot = pathFifo.acquireWrite();
+        if (slot == nullptr)
+            return;
 
-        for (int binNum = 1; binNum < numBins; binNum += pathResolution)
+        auto top = fftBounds.getY();
+        auto bottom = fftBounds.getHeight();
+        auto width = fftBounds.getWidth();
+
+        PathType& p = *slot;
+        p.clear();
+        p.preallocateSpace(3 * numPoints);
+
+        auto map = [bottom, top, negativeInfinity](float v)
         {
-            y = map(renderData[binNum]);
+            return juce::jmap(v,
+                negativeInfinity, 0.f,
+                float(bottom + 10), top);
+        };
 
-            //            jassert( !std::isnan(y) && !std::isinf(y) );
+        p.startNewSubPath(0, map(renderData[0]));
 
-            if (!std::isnan(y) && !std::isinf(y))
-            {
-                auto binFreq = binNum * binWidth;
-                auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
-                int binX = std::floor(normalizedBinX * width);
-                p.lineTo(binX, y);
-            }
-        }
+        for (int i = 1; i < numPoints; ++i)
+            p.lineTo(width * float(i) / float(numPoints - 1), map(renderData[i]));
 
-        pathFifo.push(p);
+        pathFifo.commitWrite();
     }
 
     int getNumPathsAvailable() const
@@ -162,10 +598,150 @@ struct AnalyzerPathGenerator
     {
         return pathFifo.pull(path);
     }
+
+    void release()
+    {
+        pathFifo.release();
+        columnFirstBin = {};
+        mapFFTSize = 0;
+    }
+
+    /** swaps the newest path into 'path' and discards older ones, without copying */
+    bool swapLatestPath(PathType& path)
+    {
+        bool gotPath = false;
+        while (auto* slot = pathFifo.acquireRead())
+        {
+            path.swapWithPath(*slot);
+            pathFifo.releaseRead();
+            gotPath = true;
+        }
+
+        return gotPath;
+    }
 private:
     Fifo<PathType> pathFifo;
+
+    //the bins drawn in column c are [columnFirstBin[c], columnFirstBin[c + 1])
+    std::vector<int> columnFirstBin;
+    int mapFFTSize = 0;
+    float mapBinWidth = 0;
+    int mapNumColumns = 0;
+
+    void updateColumnMap(int fftSize, float binWidth, int numColumns)
+    {
+        columnFirstBin.resize(size_t(numColumns + 1));
+
+        //bin 0 is dc; bins below 20 Hz land left of column 0 and are skipped
+        const int numBins = fftSize / 2;
+        int bin = 1;
+        for (int column = 0; column <= numColumns; ++column)
+        {
+            while (bin < numBins
+                && std::floor(juce::mapFromLog10(bin * binWidth, 20.f, 20000.f) * float(numColumns)) < float(column))
+                ++bin;
+
+            columnFirstBin[(size_t)column] = bin;
+        }
+
+        mapFFTSize = fftSize;
+        mapBinWidth = binWidth;
+        mapNumColumns = numColumns;
+    }
+};
+
+/*
+ draws the analyzer traces straight into an image's pixels instead of going
+ through strokePath's tessellation. each polyline segment is cut into one
+ vertical span per pixel column it crosses, widened to the 1 px stroke, and
+ blended in with fractional coverage at both ends for antialiasing. only the
+ spans written last frame are cleared at the start of the next one.
+ */
+struct TraceRasterizer
+{
+    /** sizes the image in physical pixels. only reallocates when something changed, and returns true if it did. */
+    bool prepare(int width, int height, float scaleFactor);
+
+    /** clears what the previous frame drew */
+    void beginFrame();
+
+    /** draws the path's line segments, shifted by offset (in logical pixels) */
+    void drawPolyline(const juce::Path& path, juce::Colour colour, juce::Point<float> offset);
+
+    /** composites the traces over everything painted so far */
+    void draw(juce::Graphics& g, juce::Rectangle<float> area) const;
+
+    void release();
+
+private:
+    juce::Image image;
+    float scale = 1.f;
+
+    //rows written per column since the last beginFrame(), as [first, last)
+    std::vector<std::pair<int, int>> dirtyRows;
+
+    void drawSegment(juce::Image::BitmapData& pixels, juce::Point<float> from, juce::Point<float> to, juce::PixelARGB colour);
+    void fillSpan(juce::Image::BitmapData& pixels, int x, float top, float bottom, juce::PixelARGB colour);
+};
+
+/*
+ pre-rendered rotary knob bodies: the filled disc, its outline and the
+ pointer at numFrames evenly spaced angles. there's one strip per knob size,
+ scale factor and enabled state, and each frame is only rendered the first
+ time it's shown, so a knob that never moves costs a single frame. frames
+ are kept up to maxBytes in total, least recently shown dropped first.
+ message thread only.
+ */
+struct KnobFilmstripCache
+{
+    //about 4 degrees apart over the 270 degree sweep
+    static constexpr int numFrames = 64;
+    static constexpr size_t maxBytes = 8 * 1024 * 1024;
+
+    struct Style
+    {
+        int diameter = 0;           //logical pixels
+        float scale = 1.f;
+        bool enabled = true;
+        float pointerInset = 0;     //distance from the centre to the pointer's inner end
+        float startAngle = 0, endAngle = 0;
+
+        bool operator==(const Style&) const = default;
+    };
+
+    /** blits the frame nearest to sliderPosProportional over bounds, rendering it first if needed */
+    void draw(juce::Graphics& g, juce::Rectangle<int> bounds, const Style& style, float sliderPosProportional);
+
+    size_t getMemoryUsage() const { return bytesUsed; }
+
+private:
+    struct Frame
+    {
+        juce::Image image;
+        juce::uint32 lastUsed = 0;
+    };
+
+    struct Strip
+    {
+        Style style;
+        std::array<Frame, numFrames> frames;
+    };
+
+    std::vector<std::unique_ptr<Strip>> strips;
+    juce::uint32 useCounter = 0;
+    size_t bytesUsed = 0;
+
+    Strip& getStrip(const Style& style);
+    void evictUntilWithinBudget(const Frame& frameInUse);
+
+    static size_t getFrameBytes(const juce::Image& image);
+    static juce::Image renderFrame(const Style& style, float angle);
 };
 
+/*
+ shared by every knob and button in every editor through a
+ SharedResourcePointer, so the filmstrips are shared as well.
+ */
 struct LookAndFeel : juce::LookAndFeel_V4
 {
     void drawRotarySlider(juce::Graphics&,
@@ -179,6 +755,8 @@ struct LookAndFeel : juce::LookAndFeel_V4
         juce::ToggleButton& toggleButton,
         bool shouldDrawButtonAsHighlighted,
         bool shouldDrawButtonAsDown) override;
+
+    KnobFilmstripCache knobFilmstrips;
 };
 
 struct RotarySliderWithLabels : juce::Slider
@@ -192,7 +770,7 @@ struct RotarySliderWithLabels : juce::Slider
         param(&rap),
         suffix(unitSuffix)
     {
-        setLookAndFeel(&this->lnf);
+        setLookAndFeel(&lnf.get());
     }
 
     ~RotarySliderWithLabels()
@@ -215,39 +793,246 @@ struct RotarySliderWithLabels : juce::Slider
 
 
 private:
-    LookAndFeel lnf;
+    juce::SharedResourcePointer<LookAndFeel> lnf;
     juce::RangedAudioParameter* param;
     juce::String suffix;
 };
 
+enum AnalyzerChannelMode
+{
+    LeftRight,
+    MidSide
+};
+
+enum AnalyzerEngine
+{
+    FFT,
+    ConstantQ
+};
+
+enum AnalyzerView
+{
+    Lines,
+    Spectrogram
+};
+
+//the value is n in 1/n octave
+enum AnalyzerSmoothing
+{
+    NoSmoothing = 0,
+    ThirdOctave = 3,
+    SixthOctave = 6,
+    TwelfthOctave = 12
+};
+
+/*
+ analyses both channels together: the two sample fifos are drained in pairs
+ so they stay aligned, and both spectra come out of a single complex fft.
+ path 0 is the first fifo's channel (or mid), path 1 the second's (or side).
+ a producer built with one output channel analyses (first + second) / 2
+ through a real fft of half the cost and only makes path 0.
+ */
 struct PathProducer
 {
-    PathProducer(SingleChannelSampleFifo<SimpleEQAudioProcessor::BlockType>& scsf) :
-        leftChannelFifo(&scsf)
+    using SampleFifo = SingleChannelSampleFifo<SimpleEQAudioProcessor::BlockType>;
+
+    PathProducer(SampleFifo& firstFifo, SampleFifo& secondFifo, int numOutputChannels = maxChannels) :
+        channelFifos{ &firstFifo, &secondFifo },
+        numChannels(numOutputChannels)
     {
-        leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
-        monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+        jassert(numChannels == 1 || numChannels == maxChannels);
     }
 
+    static constexpr int maxChannels = 2;
+    int getNumChannels() const { return numChannels; }
+
+    /** drains the fifos and builds paths. runs on the analysis thread. */
     void process(juce::Rectangle<float> fftBounds, double sampleRate);
-    juce::Path getPath() const { return leftChannelFFTPath; }
 
+    /** moves queued audio into the history without analysing it, e.g. while nothing is on screen */
+    void drainFifos();
+
+    /** true once the last 2^maxOrder samples have all been below silenceThreshold */
+    bool isInputSilent() const { return inputSilent.load(); }
+    static constexpr float silenceThreshold = 1.0e-5f; // -100 dBFS
+
+    /** swaps in the newest finished paths, if any. message thread only. */
+    bool pullLatestPaths();
+    const juce::Path& getPath(int channel) const { return channelFFTPaths[channel]; }
+
+    /** drops stale audio and history before the processor's tap is turned back on. only while off the scheduler. */
+    void resync();
+
+    /** empties the paths and spectrogram columns waiting to be shown. message thread only. */
+    void clearDisplayedAnalysis();
+
+    /** analysis storage only exists while the analyzer is shown */
+    void allocate();
+    void release();
+    bool isAllocated() const { return frameBuffer.getNumSamples() > 0; }
+
+    size_t getMemoryUsage() const;
+
+    /** fraction of each fft frame shared with the previous one, e.g. 0.5 or 0.75 */
+    void setOverlap(float newOverlap) { overlap.store(juce::jlimit(0.f, 0.9375f, newOverlap)); }
+    int getHopSize() const;
+
+    void setChannelMode(AnalyzerChannelMode newMode) { channelMode.store(newMode); }
+
+    /*
+     takes effect at the start of the next analysis frame. allocate() builds the
+     plan and window for every order and sizes everything for maxOrder, and the
+     history always holds maxOrder samples, so the switch neither allocates nor
+     waits for the history to refill.
+     */
+    void setOrder(FFTOrder newOrder) { requestedOrder.store(newOrder); }
+
+    static constexpr FFTOrder maxOrder = FFTOrder::order8192;
+
+    /** also takes effect at the start of the next analysis frame */
+    void setEngine(AnalyzerEngine newEngine) { requestedEngine.store(newEngine); }
+
+    /** fractional-octave smoothing of the fft engine's spectrum */
+    void setSmoothing(AnalyzerSmoothing newSmoothing) { smoothing.store(newSmoothing); }
+
+    /** in the spectrogram view each spectrum becomes a column instead of a pair of paths */
+    void setView(AnalyzerView newView) { view.store(newView); }
+
+    /** spectrogram columns, oldest first. message thread only. */
+    const SpectrogramColumnBuilder::Column* acquireSpectrogramColumn() { return spectrogramBuilder.acquireColumn(); }
+    void releaseSpectrogramColumn() { spectrogramBuilder.releaseColumn(); }
+
+private:
+    std::array<SampleFifo*, maxChannels> channelFifos;
+    const int numChannels;
+
+    //ring of the last 2^maxOrder samples per channel; the newest fftSize are unrolled into frameBuffer at hop boundaries
+    juce::AudioBuffer<float> history;
+    int historyWritePos = 0;
+    int samplesSinceLastFFT = 0;
+    int silentRunLength = 0;
+    bool publishedSilentFrame = false;
+    std::atomic<bool> inputSilent{ false };
+    std::atomic<float> overlap{ 0.5f };
+    std::atomic<AnalyzerChannelMode> channelMode{ AnalyzerChannelMode::LeftRight };
+    std::atomic<FFTOrder> requestedOrder{ FFTOrder::order2048 };
+    std::atomic<AnalyzerEngine> requestedEngine{ AnalyzerEngine::FFT };
+    AnalyzerEngine engine = AnalyzerEngine::FFT;
+    std::atomic<AnalyzerSmoothing> smoothing{ AnalyzerSmoothing::NoSmoothing };
+    std::atomic<AnalyzerView> view{ AnalyzerView::Lines };
+
+    void pushIntoHistory(const SimpleEQAudioProcessor::BlockType& first,
+        const SimpleEQAudioProcessor::BlockType& second);
+    void copyHistoryToFrameBuffer();
+
+    juce::AudioBuffer<float> frameBuffer;
+
+    FFTDataGenerator<std::vector<float>> fftDataGenerator;
+    MultirateSpectrumGenerator multirateGenerator;
+    SpectrumSmoother smoother;
+    SpectrogramColumnBuilder spectrogramBuilder;
+
+    std::array<AnalyzerPathGenerator<juce::Path>, maxChannels> pathGenerators;
+
+    std::array<juce::Path, maxChannels> channelFFTPaths;
+};
+
+/*
+ one frame clock and worker pool shared by every open analyzer in the process.
+ each frame the clock thread hands the registered clients out to itself and
+ the pool, waits for the whole batch, then sleeps until the next frame.
+ */
+struct AnalysisScheduler : juce::Thread
+{
+    struct Client
+    {
+        virtual ~Client() = default;
+
+        /** called once per frame on a scheduler thread */
+        virtual void runAnalysisFrame() = 0;
+    };
+
+    AnalysisScheduler();
+    ~AnalysisScheduler() override;
+
+    void addClient(Client* client);
+
+    /** blocks until the client's frame in flight, if any, has finished */
+    void removeClient(Client* client);
+
+    void run() override;
+
+    static constexpr int frameRateHz = 60;
 private:
-    SingleChannelSampleFifo<SimpleEQAudioProcessor::BlockType>* leftChannelFifo;
-    //SingleChannelSampleFifo<SimpleEQAudioProcessor::BlockType>* rightChannelFifo;
+    struct HelperJob : juce::ThreadPoolJob
+    {
+        HelperJob(AnalysisScheduler& s) : juce::ThreadPoolJob("SimpleEQ Analysis"), scheduler(s) {}
 
-    juce::AudioBuffer<float> monoBuffer;
+        JobStatus runJob() override
+        {
+            scheduler.processClients();
+            return jobHasFinished;
+        }
 
-    FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
+        AnalysisScheduler& scheduler;
+    };
 
-    AnalyzerPathGenerator<juce::Path> pathProducer;
+    void runFrame();
+    void processClients();
 
-    juce::Path leftChannelFFTPath;
+    //held for the whole of a frame, so clients can't come or go mid-batch
+    juce::CriticalSection clientLock;
+    juce::Array<Client*> clients;
+    std::atomic<int> nextClient{ 0 };
+
+    juce::OwnedArray<HelperJob> helpers;
+    juce::ThreadPool pool;
+};
+
+/*
+ picks a refresh rate between minRateHz and maxRateHz that keeps the measured
+ cost of a frame (analysis + paint) within a budget, given as a fraction of
+ one core. the cost is smoothed, and small changes are ignored so the rate
+ doesn't hunt around the limit.
+ */
+struct AdaptiveFrameRate
+{
+    static constexpr int minRateHz = 15;
+    static constexpr int maxRateHz = AnalysisScheduler::frameRateHz;
+
+    void setBudget(double fractionOfCore) { budget = juce::jlimit(0.001, 1.0, fractionOfCore); }
+    double getBudget() const { return budget; }
+
+    /** feeds in the time one frame took; returns true when the rate should change */
+    bool addFrame(double secondsSpent)
+    {
+        averageFrameCost += 0.1 * (secondsSpent - averageFrameCost);
+
+        auto affordableRate = averageFrameCost > 0 ? budget / averageFrameCost : double(maxRateHz);
+        auto target = juce::jlimit(minRateHz, maxRateHz, (int)affordableRate);
+
+        if (std::abs(target - rateHz) < juce::jmax(2, rateHz / 10))
+            return false;
+
+        rateHz = target;
+        return true;
+    }
+
+    int getRateHz() const { return rateHz; }
+    double getAverageFrameCost() const { return averageFrameCost; }
+
+private:
+    double budget = 0.05;
+    double averageFrameCost = 0;
+    int rateHz = maxRateHz;
 };
 
 struct ResponseCurveComponent : juce::Component,
     juce::AudioProcessorParameter::Listener,
-    juce::Timer
+    juce::Timer,
+    juce::AsyncUpdater,
+    AnalysisScheduler::Client,
+    SimpleEQAudioProcessor::AnalyzerConsumer
 {
     ResponseCurveComponent(SimpleEQAudioProcessor&);
     ~ResponseCurveComponent();
@@ -258,12 +1043,54 @@ struct ResponseCurveComponent : juce::Component,
 
     void timerCallback() override;
 
+    void handleAsyncUpdate() override;
+
+    /** scrolls the spectrogram back through its history */
+    void mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel) override;
+
+    /**
+     hands the current bounds and sample rate to the analysis thread, then swaps in
+     whatever it has finished since: new paths and spectrogram columns. returns true
+     if anything arrived. called by the timer; message thread only.
+     */
+    bool pullAnalysis();
+
     void paint(juce::Graphics& g) override;
 
     void resized() override;
 
     void toggleAnalysisEnablement(bool isEnabled);
 
+    /** heap bytes held by this analyzer and the processor's analyzer fifos */
+    size_t getAnalyzerMemoryUsage() const;
+
+    void setAnalyzerOverlap(float overlap);
+    void setAnalyzerChannelMode(AnalyzerChannelMode mode) { pathProducer.setChannelMode(mode); }
+    void setAnalyzerOrder(FFTOrder order);
+    void setAnalyzerEngine(AnalyzerEngine engine);
+    void setAnalyzerSmoothing(AnalyzerSmoothing smoothing);
+    void setAnalyzerView(AnalyzerView view);
+
+    /** overlays the spectrum of the input, before the filters, behind the output's */
+    void setPreEQOverlayVisible(bool shouldBeVisible);
+
+    /** one analysis pass over both channels. called on a scheduler thread. */
+    void runAnalysisFrame() override;
+
+    void suspendAnalyzerReads() override;
+    void resumeAnalyzerReads() override;
+
+    /*
+     the refresh rate adapts to keep analysis + paint within a cpu budget,
+     and updates stop while the component isn't showing or the input is silent.
+     */
+    void setCpuBudget(double fractionOfCore) { frameRate.setBudget(fractionOfCore); }
+    double getCpuBudget() const { return frameRate.getBudget(); }
+    /** the rate the timer is running at right now, idleRateHz while hidden or idle. message thread only. */
+    int getEffectiveFrameRate() const { return timerRateHz; }
+    double getAverageFrameCost() const { return frameRate.getAverageFrameCost(); }
+    bool isAnalysisPaused() const { return analysisPaused.load() || pathProducer.isInputSilent(); }
+
 private:
     SimpleEQAudioProcessor& audioProcessor;
     
@@ -273,16 +1100,94 @@ private:
 
     void updateChain();
 
+    //the magnitude response, cached between parameter changes
+    juce::Path responseCurve;
+    std::vector<double> responseCurveMagnitudes;
+    FrequencyResponseEvaluator responseEvaluator;
+    ResponseSnapshot responseSnapshot;
+    double responseCurveSampleRate = 0;
+    bool responseCurveNeedsUpdate = true;
+
+    void updateResponseCurve();
+
+    /*
+     paint composites cached layers: the grid in 'background', the response
+     curve, and the analyzer (traceRasterizer or spectrogramView). a layer is
+     only re-rendered when its dirty flag is set, and the timer only repaints
+     the bounds of the layers that changed.
+     */
+    juce::Image responseCurveLayer;
+    bool responseCurveLayerDirty = true;
+    bool analyzerLayerDirty = true;
+
+    bool isLayerSized(const juce::Image& layer, float scale) const;
+    void renderResponseCurveLayer(float scale);
+    void renderAnalyzerLayer();
+
+    //the grid and labels only depend on size, so every editor at the same
+    //size and scale shares one image through juce::ImageCache
     juce::Image background;
+    void renderBackground(float scale);
+    void drawBackground(juce::Graphics& g);
+
+    //the analyzer is attached on the first tick after the first paint, so it
+    //doesn't hold up the editor opening
+    bool hasPainted = false;
 
     juce::Rectangle<int> getRenderArea();
 
     juce::Rectangle<int> getAnalysisArea();
 
-    PathProducer leftPathProducer, rightPathProducer;
+    PathProducer pathProducer;
+
+    //mono sum of the input. shares the scheduler frame, and the window
+    //tables through FFTResourceCache, with pathProducer.
+    PathProducer prePathProducer;
+    bool showPreEQOverlay = false;
+    bool isPreTapActive = false;
+
+    void updatePreAnalyzerTap();
 
     bool displayFFTAnalysis = true;
 
+    AnalyzerView analyzerView = AnalyzerView::Lines;
+    SpectrogramView spectrogramView;
+    TraceRasterizer traceRasterizer;
+
+    void updateAnalyzerTap(bool consumerAttached);
+
+    juce::SharedResourcePointer<AnalysisScheduler> analysisScheduler;
+    bool isRegisteredForAnalysis = false;
+
+    //resumeAnalyzerReads() runs on whichever thread the host prepares on, so
+    //the producers are resynced and re-registered from handleAsyncUpdate()
+    std::atomic<bool> analyzerRestartPending{ false };
+    void restartAnalysis();
+
+    AdaptiveFrameRate frameRate;
+    int timerRateHz = AdaptiveFrameRate::maxRateHz;
+    double paintSecondsSinceLastTick = 0;
+
+    //hidden, or silent with nothing else changing: just poll for coming back
+    static constexpr int idleRateHz = 4;
+    static constexpr double idleAfterSeconds = 1.0;
+    double lastActivityTime = 0;
+    //set while polling at idleRateHz, so a parameter change can bring the rate back straight away
+    std::atomic<bool> timerIsIdle{ false };
+    void setTimerRate(int rateHz);
+    void updateFrameRate();
+
+    //the analysis thread runs every analysisFrameInterval-th scheduler frame, and only drains while paused
+    std::atomic<juce::int64> analysisTicksSinceLastTick{ 0 };
+    std::atomic<int> analysisFrameInterval{ 1 };
+    std::atomic<bool> analysisPaused{ false };
+    int analysisFrameCounter = 0;
+
+    //written by the message thread every frame, read by the analysis thread
+    juce::SpinLock analysisSettingsLock;
+    juce::Rectangle<float> analysisBounds;
+    double analysisSampleRate = 0;
+
     //SingleChannelSampleFifo<SimpleEQAudioProcessor::BlockType>* leftChannelFifo;
     ////SingleChannelSampleFifo<SimpleEQAudioProcessor::BlockType>* rightChannelFifo;
 
@@ -369,6 +1274,9 @@ private:
 
     AnalyzerButton analyzerEnabledButton;
 
+    juce::ComboBox analyzerChannelModeBox, analyzerResolutionBox, analyzerEngineBox, analyzerSmoothingBox, analyzerViewBox;
+    juce::ToggleButton preEQOverlayButton{ "Pre EQ" };
+
     using ButtonAttachment = APVTS::ButtonAttachment;
 
     ButtonAttachment 
@@ -379,7 +1287,7 @@ private:
 
     std::vector<juce::Component*> getComps();
 
-    LookAndFeel lnf;
+    juce::SharedResourcePointer<LookAndFeel> lnf;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEQAudioProcessorEditor)
 };
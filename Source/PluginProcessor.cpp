@@ -22,6 +22,13 @@ SimpleEQAudioProcessor::SimpleEQAudioProcessor()
                        )
 #endif
 {
+    for (int i = 0; i < numStateParameters; ++i)
+    {
+        stateParameters[i] = apvts.getParameter(stateParameterIDs[i]);
+        jassert(stateParameters[i] != nullptr);
+    }
+
+    analyzerEnabled = apvts.getRawParameterValue("Analyzer Enabled");
 }
 
 SimpleEQAudioProcessor::~SimpleEQAudioProcessor()
@@ -109,14 +116,124 @@ void SimpleEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
 
     updateFilters();
 
-    leftChannelFifo.prepare(samplesPerBlock);
-    rightChannelFifo.prepare(samplesPerBlock);
+    const juce::ScopedLock sl(analyzerStorageLock);
+    analyzerBlockSize = samplesPerBlock;
+    analyzerTapWasActive = false;
+    preAnalyzerTapWasActive = false;
+
+    //the fifos are mono, so the block size is all that can make the storage stale
+    auto isSized = [samplesPerBlock](const auto& fifo) { return fifo.isPrepared() && fifo.getSize() == samplesPerBlock; };
+    auto resizeTap = analyzerTapWanted && !(isSized(leftChannelFifo) && isSized(rightChannelFifo));
+    auto resizePreTap = preAnalyzerTapWanted && !(isSized(preLeftChannelFifo) && isSized(preRightChannelFifo));
+
+    if (!resizeTap && !resizePreTap)
+        return;
+
+    //the reader must be off the slots before they're resized under it
+    if (analyzerConsumer != nullptr)
+        analyzerConsumer->suspendAnalyzerReads();
+
+    if (resizeTap)
+    {
+        analyzerTapActive.store(false);
+        waitForAnalyzerTapToFinish();
+        prepareAnalyzerStorage();
+    }
+
+    if (resizePreTap)
+    {
+        preAnalyzerTapActive.store(false);
+        waitForAnalyzerTapToFinish();
+        preparePreAnalyzerStorage();
+    }
+
+    if (analyzerConsumer != nullptr)
+        analyzerConsumer->resumeAnalyzerReads();
+}
+
+void SimpleEQAudioProcessor::setAnalyzerConsumer(AnalyzerConsumer* consumer)
+{
+    const juce::ScopedLock sl(analyzerStorageLock);
+    analyzerConsumer = consumer;
+}
+
+void SimpleEQAudioProcessor::prepareAnalyzerStorage()
+{
+    leftChannelFifo.prepare(analyzerBlockSize);
+    rightChannelFifo.prepare(analyzerBlockSize);
+    analyzerTapActive.store(true);
+}
+
+void SimpleEQAudioProcessor::preparePreAnalyzerStorage()
+{
+    preLeftChannelFifo.prepare(analyzerBlockSize);
+    preRightChannelFifo.prepare(analyzerBlockSize);
+    preAnalyzerTapActive.store(true);
+}
+
+void SimpleEQAudioProcessor::waitForAnalyzerTapToFinish()
+{
+    //the caller has cleared a tap flag, so only a block already running can still see the old value.
+    //an offline render can start the next block straight away, so waiting for a gap between
+    //blocks may never end; the end of the block in flight is enough.
+    auto blocksFinished = analyzerTapBlocksFinished.load();
+    while (analyzerTapInUse.load() && analyzerTapBlocksFinished.load() == blocksFinished)
+        std::this_thread::yield();
+}
+
+void SimpleEQAudioProcessor::setAnalyzerTapActive(bool shouldBeActive)
+{
+    const juce::ScopedLock sl(analyzerStorageLock);
+
+    if (shouldBeActive == analyzerTapWanted)
+        return;
+
+    analyzerTapWanted = shouldBeActive;
+
+    if (shouldBeActive)
+    {
+        if (analyzerBlockSize > 0)
+            prepareAnalyzerStorage();
+
+        return;
+    }
+
+    //wait for the audio thread to leave the tap before freeing what it writes to
+    analyzerTapActive.store(false);
+    waitForAnalyzerTapToFinish();
+
+    leftChannelFifo.release();
+    rightChannelFifo.release();
+}
+
+void SimpleEQAudioProcessor::setPreAnalyzerTapActive(bool shouldBeActive)
+{
+    const juce::ScopedLock sl(analyzerStorageLock);
+
+    if (shouldBeActive == preAnalyzerTapWanted)
+        return;
+
+    preAnalyzerTapWanted = shouldBeActive;
+
+    if (shouldBeActive)
+    {
+        if (analyzerBlockSize > 0)
+            preparePreAnalyzerStorage();
+
+        return;
+    }
 
-    osc.initialise([](float x) {return std::sin(x); });
+    preAnalyzerTapActive.store(false);
+    waitForAnalyzerTapToFinish();
 
-    spec.numChannels = getTotalNumOutputChannels();
-    osc.prepare(spec);
-    osc.setFrequency(200);
+    preLeftChannelFifo.release();
+    preRightChannelFifo.release();
+}
+
+size_t SimpleEQAudioProcessor::getAnalyzerMemoryUsage() const
+{
+    return leftChannelFifo.getMemoryUsage() + rightChannelFifo.getMemoryUsage()
+        + preLeftChannelFifo.getMemoryUsage() + preRightChannelFifo.getMemoryUsage();
 }
 
 void SimpleEQAudioProcessor::releaseResources()
@@ -163,12 +280,26 @@ void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
         
     updateFilters();
 
-    juce::dsp::AudioBlock<float> block(buffer);
-
-    //buffer.clear();
+    //nobody is looking at the analyzer most of the time, so skip the taps entirely.
+    //analyzerTapInUse lets setAnalyzerTapActive(false) and setPreAnalyzerTapActive(false)
+    //know when the fifos are safe to free.
+    analyzerTapInUse.store(true);
+    auto tapActive = analyzerTapActive.load() && analyzerEnabled->load() > 0.5f;
+    auto preTapActive = tapActive && preAnalyzerTapActive.load();
+    if (preTapActive)
+    {
+        if (!preAnalyzerTapWasActive)
+        {
+            preLeftChannelFifo.resync();
+            preRightChannelFifo.resync();
+        }
+
+        preLeftChannelFifo.update(buffer);
+        preRightChannelFifo.update(buffer);
+    }
+    preAnalyzerTapWasActive = preTapActive;
 
-    //juce::dsp::ProcessContextReplacing<float> stereoContext(block);
-    //osc.process(stereoContext);
+    juce::dsp::AudioBlock<float> block(buffer);
 
     auto leftBlock = block.getSingleChannelBlock(0);
     auto rightBlock = block.getSingleChannelBlock(1);
@@ -179,8 +310,20 @@ void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     leftChain.process(leftContext);
     rightChain.process(rightContext);
 
-    leftChannelFifo.update(buffer);
-    rightChannelFifo.update(buffer);
+    if (tapActive)
+    {
+        if (!analyzerTapWasActive)
+        {
+            leftChannelFifo.resync();
+            rightChannelFifo.resync();
+        }
+
+        leftChannelFifo.update(buffer);
+        rightChannelFifo.update(buffer);
+    }
+    analyzerTapWasActive = tapActive;
+    analyzerTapInUse.store(false);
+    analyzerTapBlocksFinished.fetch_add(1);
 }
 
 //==============================================================================
@@ -197,27 +340,135 @@ juce::AudioProcessorEditor* SimpleEQAudioProcessor::createEditor()
 }
 
 //==============================================================================
+const char* const SimpleEQAudioProcessor::stateParameterIDs[numStateParameters]
+{
+    // append only: the binary state layout depends on this order
+    "LowCut Freq",
+    "HighCut Freq",
+    "Peak Freq",
+    "Peak Gain",
+    "Peak Quality",
+    "LowCut Slope",
+    "HighCut Slope",
+    "LowCut Bypassed",
+    "Peak Bypassed",
+    "HighCut Bypassed",
+    "Analyzer Enabled"
+};
+
+namespace
+{
+    constexpr int stateHeaderSize = 3 * sizeof(juce::uint32);
+
+    //FNV-1a, cheap and good enough to reject truncated or foreign blobs
+    juce::uint32 computeStateChecksum(const void* data, size_t numBytes)
+    {
+        auto* bytes = static_cast<const juce::uint8*>(data);
+        juce::uint32 hash = 2166136261u;
+
+        for (size_t i = 0; i < numBytes; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 16777619u;
+        }
+
+        return hash;
+    }
+}
+
 void SimpleEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    juce::MemoryOutputStream mos(destData, false);
+    mos.writeInt((int)stateMagic);
+    mos.writeInt((int)stateVersion);
+    mos.writeInt(numStateParameters);
+
+    for (auto* param : stateParameters)
+    {
+        mos.writeFloat(param->convertFrom0to1(param->getValue()));
+    }
 
-    juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
+    auto checksum = computeStateChecksum(mos.getData(), mos.getDataSize());
+    mos.writeInt((int)checksum);
 }
 
 void SimpleEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    if (restoreBinaryState(data, sizeInBytes))
+        return;
 
+    //sessions saved before the binary format hold the whole apvts ValueTree
     auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
-    if (tree.isValid())
+    if (tree.hasType(apvts.state.getType()))
     {
         apvts.replaceState(tree);
-        updateFilters();
+
+        if (getSampleRate() > 0)
+            updateFilters();
+    }
+}
+
+bool SimpleEQAudioProcessor::restoreBinaryState(const void* data, int sizeInBytes)
+{
+    if (data == nullptr || sizeInBytes < (int)sizeof(juce::uint32))
+        return false;
+
+    juce::MemoryInputStream mis(data, (size_t)sizeInBytes, false);
+
+    if ((juce::uint32)mis.readInt() != stateMagic)
+        return false;
+
+    //the blob is ours from here on, so anything we can't read keeps the current state
+    if (sizeInBytes < stateHeaderSize + (int)sizeof(juce::uint32))
+    {
+        jassertfalse;
+        return true;
+    }
+
+    auto version = (juce::uint32)mis.readInt();
+    auto numStored = mis.readInt();
+
+    //a newer format can't be assumed to be laid out like this one
+    if (version == 0 || version > stateVersion)
+        return true;
+
+    //bounded before multiplying, so a corrupt count can't overflow past the size check
+    auto maxStored = (sizeInBytes - stateHeaderSize - (int)sizeof(juce::uint32)) / (int)sizeof(float);
+    if (numStored < 0 || numStored > maxStored)
+    {
+        jassertfalse;
+        return true;
     }
+
+    auto payloadSize = stateHeaderSize + numStored * (int)sizeof(float);
+
+    auto storedChecksum = (juce::uint32)juce::ByteOrder::littleEndianInt(
+        static_cast<const char*>(data) + payloadSize);
+    if (storedChecksum != computeStateChecksum(data, (size_t)payloadSize))
+    {
+        //the blob claims to be ours but is damaged; keep the current state
+        jassertfalse;
+        return true;
+    }
+
+    //older sessions may lack parameters added since
+    auto numToRead = juce::jmin(numStored, numStateParameters);
+    for (int i = 0; i < numToRead; ++i)
+    {
+        auto* param = stateParameters[i];
+        auto normalised = param->convertTo0to1(mis.readFloat());
+
+        //only touch parameters that moved, so unchanged ones don't notify listeners
+        if (param->getValue() != normalised)
+            param->setValueNotifyingHost(normalised);
+    }
+
+    //before prepareToPlay there is no sample rate to design filters for;
+    //prepareToPlay will call updateFilters itself
+    if (getSampleRate() > 0)
+        updateFilters();
+
+    return true;
 }
 
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
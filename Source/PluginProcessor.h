@@ -10,9 +10,18 @@
 
 #include <JuceHeader.h>
 
-template<typename T>
+/*
+ single-producer/single-consumer ring of preallocated slots.
+ the producer fills a slot in place between acquireWrite() and commitWrite(),
+ the consumer reads one in place between acquireRead() and releaseRead(),
+ so nothing is copied or reallocated on either thread.
+ */
+template<typename T, size_t Capacity = 32>
 struct Fifo
 {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+        "Fifo capacity must be a power of two");
+
     void prepare(int numChannels, int numSamples)
     {
         static_assert(std::is_same_v<T, juce::AudioBuffer<float>>,
@@ -39,12 +48,44 @@ struct Fifo
         }
     }
 
+    //==============================================================================
+    /** returns the next free slot, or nullptr when full. calling it again before commitWrite() returns the same slot. */
+    T* acquireWrite()
+    {
+        auto write = writeIndex.load(std::memory_order_relaxed);
+        if (write - readIndex.load(std::memory_order_acquire) == Capacity)
+            return nullptr;
+
+        return &buffers[write & mask];
+    }
+
+    void commitWrite()
+    {
+        writeIndex.store(writeIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /** returns the oldest filled slot, or nullptr when empty. */
+    T* acquireRead()
+    {
+        auto read = readIndex.load(std::memory_order_relaxed);
+        if (read == writeIndex.load(std::memory_order_acquire))
+            return nullptr;
+
+        return &buffers[read & mask];
+    }
+
+    void releaseRead()
+    {
+        readIndex.store(readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    //==============================================================================
     bool push(const T& t)
     {
-        auto write = fifo.write(1);
-        if (write.blockSize1 > 0)
+        if (auto* slot = acquireWrite())
         {
-            buffers[write.startIndex1] = t;
+            *slot = t;
+            commitWrite();
             return true;
         }
 
@@ -53,10 +94,10 @@ struct Fifo
 
     bool pull(T& t)
     {
-        auto read = fifo.read(1);
-        if (read.blockSize1 > 0)
+        if (auto* slot = acquireRead())
         {
-            t = buffers[read.startIndex1];
+            t = *slot;
+            releaseRead();
             return true;
         }
 
@@ -65,12 +106,45 @@ struct Fifo
 
     int getNumAvailableForReading() const
     {
-        return fifo.getNumReady();
+        return int(writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire));
     }
+
+    /** frees every slot's storage and empties the ring. neither side may be using the fifo. */
+    void release()
+    {
+        for (auto& buffer : buffers)
+            buffer = T();
+
+        writeIndex.store(0);
+        readIndex.store(0);
+    }
+
+    /** heap bytes held by the slots */
+    size_t getMemoryUsage() const
+    {
+        size_t bytes = 0;
+        for (const auto& buffer : buffers)
+        {
+            if constexpr (std::is_same_v<T, juce::AudioBuffer<float>>)
+                bytes += size_t(buffer.getNumChannels()) * size_t(buffer.getNumSamples()) * sizeof(float);
+            else if constexpr (std::is_same_v<T, std::vector<float>>)
+                bytes += buffer.capacity() * sizeof(float);
+            else
+                juce::ignoreUnused(buffer); //juce::Path doesn't expose its storage size
+        }
+
+        return bytes;
+    }
+
+    static constexpr size_t getCapacity() { return Capacity; }
 private:
-    static constexpr int Capacity = 30;
-    std::array<T, Capacity> buffers;
-    juce::AbstractFifo fifo{ Capacity };
+    static constexpr size_t mask = Capacity - 1;
+    static constexpr size_t cacheLineSize = 64;
+
+    //each index sits on its own cache line so the two threads don't false-share
+    alignas(cacheLineSize) std::atomic<size_t> writeIndex{ 0 };
+    alignas(cacheLineSize) std::atomic<size_t> readIndex{ 0 };
+    alignas(cacheLineSize) std::array<T, Capacity> buffers;
 };
 
 enum Channel
@@ -92,10 +166,27 @@ struct SingleChannelSampleFifo
         jassert(prepared.get());
         jassert(buffer.getNumChannels() > channelToUse);
         auto* channelPtr = buffer.getReadPointer(channelToUse);
+        auto numSamples = buffer.getNumSamples();
 
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        //copy contiguous spans straight into the fifo slot being filled.
+        //host blocks may be larger or smaller than the prepared size, so a
+        //block can complete several slots or only part of one.
+        int index = 0;
+        while (index < numSamples)
         {
-            pushNextSampleIntoFifo(channelPtr[i]);
+            if (fillTarget == nullptr)
+                beginNextBuffer();
+
+            auto numToCopy = juce::jmin(numSamples - index, bufferSize - fifoIndex);
+            juce::FloatVectorOperations::copy(fillTarget->getWritePointer(0, fifoIndex),
+                channelPtr + index,
+                numToCopy);
+
+            index += numToCopy;
+            fifoIndex += numToCopy;
+
+            if (fifoIndex == bufferSize)
+                finishBuffer();
         }
     }
 
@@ -110,7 +201,9 @@ struct SingleChannelSampleFifo
             true,          //clear extra space
             true);         //avoid reallocating
         audioBufferFifo.prepare(1, bufferSize);
+        this->bufferSize = bufferSize;
         fifoIndex = 0;
+        fillTarget = nullptr;
         prepared.set(true);
     }
     //==============================================================================
@@ -119,27 +212,69 @@ struct SingleChannelSampleFifo
     int getSize() const { return size.get(); }
     //==============================================================================
     bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
+
+    /** in-place access to the oldest complete buffer; pair with releaseAudioBuffer() */
+    const BlockType* acquireAudioBuffer() { return audioBufferFifo.acquireRead(); }
+    void releaseAudioBuffer() { audioBufferFifo.releaseRead(); }
+
+    /** producer side: forget any partly filled buffer. audio thread only. */
+    void resync()
+    {
+        fillTarget = nullptr;
+        fifoIndex = 0;
+    }
+
+    /** frees all storage; prepare() must be called again before update(). */
+    void release()
+    {
+        prepared.set(false);
+        audioBufferFifo.release();
+        bufferToFill = BlockType();
+        fillTarget = nullptr;
+        fifoIndex = 0;
+    }
+
+    size_t getMemoryUsage() const
+    {
+        return audioBufferFifo.getMemoryUsage()
+            + size_t(bufferToFill.getNumChannels()) * size_t(bufferToFill.getNumSamples()) * sizeof(float);
+    }
+
+    /** consumer side: drop every complete buffer still waiting to be read. */
+    void discardPending()
+    {
+        while (audioBufferFifo.acquireRead() != nullptr)
+            audioBufferFifo.releaseRead();
+    }
 private:
     Channel channelToUse;
     int fifoIndex = 0;
+    int bufferSize = 0;
     Fifo<BlockType> audioBufferFifo;
     BlockType bufferToFill;
+    BlockType* fillTarget = nullptr;
+    bool fillingFifoSlot = false;
     juce::Atomic<bool> prepared = false;
     juce::Atomic<int> size = 0;
 
-    void pushNextSampleIntoFifo(float sample)
+    void beginNextBuffer()
     {
-        if (fifoIndex == bufferToFill.getNumSamples())
-        {
-            auto ok = audioBufferFifo.push(bufferToFill);
+        //fill a fifo slot in place; if the consumer has fallen behind,
+        //fill the scratch buffer instead and drop it when complete
+        fillTarget = audioBufferFifo.acquireWrite();
+        fillingFifoSlot = fillTarget != nullptr;
 
-            juce::ignoreUnused(ok);
+        if (!fillingFifoSlot)
+            fillTarget = &bufferToFill;
+    }
 
-            fifoIndex = 0;
-        }
+    void finishBuffer()
+    {
+        if (fillingFifoSlot)
+            audioBufferFifo.commitWrite();
 
-        bufferToFill.setSample(0, fifoIndex, sample);
-        ++fifoIndex;
+        fillTarget = nullptr;
+        fifoIndex = 0;
     }
 };
 
@@ -277,6 +412,16 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    /*
+     compact binary state: a fixed header, one float per parameter in
+     stateParameterIDs order, then a checksum over everything before it.
+     sessions saved before this format are ValueTree blobs and still load.
+     */
+    static constexpr juce::uint32 stateMagic = 0x42514553; // "SEQB"
+    static constexpr juce::uint32 stateVersion = 1;
+    static constexpr int numStateParameters = 11;
+    static const char* const stateParameterIDs[numStateParameters];
+
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts{
         *this,
@@ -289,6 +434,53 @@ public:
     SingleChannelSampleFifo<BlockType> leftChannelFifo{ Channel::Left };
     SingleChannelSampleFifo<BlockType> rightChannelFifo{ Channel::Right };
 
+    /*
+     the analyzer fifos are only fed while an editor's analyzer is attached
+     and showing the spectrum. the consumer drains the fifos before turning
+     the tap on, and the audio thread resyncs them on the first block after.
+
+     the fifos' storage only exists while the tap is wanted: it is allocated
+     here (or in prepareToPlay, if the block size isn't known yet) and freed
+     again when the tap is turned off. call from the message thread.
+     */
+    void setAnalyzerTapActive(bool shouldBeActive);
+    bool isAnalyzerTapActive() const { return analyzerTapActive.load(); }
+
+    /*
+     the same again for the input, tapped before the filters, so the editor
+     can overlay it. it is only fed while the analyzer tap is fed too.
+     */
+    SingleChannelSampleFifo<BlockType> preLeftChannelFifo{ Channel::Left };
+    SingleChannelSampleFifo<BlockType> preRightChannelFifo{ Channel::Right };
+
+    void setPreAnalyzerTapActive(bool shouldBeActive);
+    bool isPreAnalyzerTapActive() const { return preAnalyzerTapActive.load(); }
+
+    /** heap bytes currently held by the analyzer fifos */
+    size_t getAnalyzerMemoryUsage() const;
+
+    /*
+     whoever reads the analyzer fifos. when prepareToPlay has to resize them
+     it detaches the reader first and re-attaches it afterwards, the same
+     handshake the editor does around turning the tap on and off. both calls
+     are made with the analyzer storage locked.
+     */
+    struct AnalyzerConsumer
+    {
+        virtual ~AnalyzerConsumer() = default;
+
+        /** stop reading the fifos. must not return while a read is still in flight. */
+        virtual void suspendAnalyzerReads() = 0;
+
+        /** the fifos were re-prepared: drop anything stale and start reading again */
+        virtual void resumeAnalyzerReads() = 0;
+    };
+
+    void setAnalyzerConsumer(AnalyzerConsumer* consumer);
+
+    /** held by the consumer while it attaches or detaches, so prepareToPlay can't interleave */
+    const juce::CriticalSection& getAnalyzerStorageLock() const { return analyzerStorageLock; }
+
 private: 
     MonoChain leftChain, rightChain;
 
@@ -299,7 +491,28 @@ private:
 
     void updateFilters();
 
-    juce::dsp::Oscillator<float> osc;
+    std::array<juce::RangedAudioParameter*, numStateParameters> stateParameters{};
+    std::atomic<float>* analyzerEnabled = nullptr;
+
+    std::atomic<bool> analyzerTapActive{ false };
+    std::atomic<bool> analyzerTapInUse{ false };
+    std::atomic<juce::uint32> analyzerTapBlocksFinished{ 0 };
+    bool analyzerTapWasActive = false;
+
+    std::atomic<bool> preAnalyzerTapActive{ false };
+    bool preAnalyzerTapWasActive = false;
+
+    juce::CriticalSection analyzerStorageLock;
+    bool analyzerTapWanted = false;
+    bool preAnalyzerTapWanted = false;
+    int analyzerBlockSize = 0;
+    AnalyzerConsumer* analyzerConsumer = nullptr;
+
+    void prepareAnalyzerStorage();
+    void preparePreAnalyzerStorage();
+    void waitForAnalyzerTapToFinish();
+
+    bool restoreBinaryState(const void* data, int sizeInBytes);
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEQAudioProcessor)